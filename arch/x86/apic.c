@@ -30,6 +30,19 @@ static enum apic_mode apicbase_to_mode(uint64_t apicbase)
     }
 }
 
+static void set_apicbase_mode(uint64_t msrval, enum apic_mode mode)
+{
+    msrval &= ~(APICBASE_EXTD | APICBASE_ENABLE);
+
+    wrmsr(MSR_APICBASE, msrval);
+
+    if ( mode == APIC_MODE_XAPIC || mode == APIC_MODE_X2APIC )
+        wrmsr(MSR_APICBASE, msrval | APICBASE_ENABLE);
+
+    if ( mode == APIC_MODE_X2APIC )
+        wrmsr(MSR_APICBASE, msrval | APICBASE_ENABLE | APICBASE_EXTD);
+}
+
 int apic_init(enum apic_mode mode)
 {
     uint64_t msrval;
@@ -74,17 +87,7 @@ int apic_init(enum apic_mode mode)
      */
     if ( mode != cur_apic_mode )
     {
-        msrval = rdmsr(MSR_APICBASE) &
-            ~(APICBASE_EXTD | APICBASE_ENABLE);
-
-        wrmsr(MSR_APICBASE, msrval);
-
-        if ( mode == APIC_MODE_XAPIC || mode == APIC_MODE_X2APIC )
-            wrmsr(MSR_APICBASE, msrval | APICBASE_ENABLE);
-
-        if ( mode == APIC_MODE_X2APIC )
-            wrmsr(MSR_APICBASE, msrval | APICBASE_ENABLE | APICBASE_EXTD);
-
+        set_apicbase_mode(rdmsr(MSR_APICBASE), mode);
         cur_apic_mode = mode;
     }
 
@@ -97,6 +100,22 @@ int apic_init(enum apic_mode mode)
     return 0;
 }
 
+int apic_init_ap(void)
+{
+    uint64_t msrval = rdmsr(MSR_APICBASE);
+
+    if ( cur_apic_mode != APIC_MODE_XAPIC &&
+         cur_apic_mode != APIC_MODE_X2APIC )
+        return -ENODEV;
+
+    if ( apicbase_to_mode(msrval) != cur_apic_mode )
+        set_apicbase_mode(msrval, cur_apic_mode);
+
+    apic_write(APIC_SPIV, APIC_SPIV_APIC_ENABLED | 0xff);
+
+    return 0;
+}
+
 /*
  * Local variables:
  * mode: C
@@ -0,0 +1,371 @@
+/**
+ * @file arch/x86/hvm/pagetable.c
+ *
+ * Runtime construction of mappings in the live HVM pagetables.
+ */
+#include <xtf/lib.h>
+#include <xtf/page_alloc.h>
+#include <xtf/spinlock.h>
+
+#include <arch/cpuid.h>
+#include <arch/lib.h>
+#include <arch/msr.h>
+#include <arch/pagetable.h>
+#include <arch/processor.h>
+#include <arch/symbolic-const.h>
+
+#include <xen/errno.h>
+
+#if CONFIG_PAGING_LEVELS > 0
+
+static struct ticket_lock pt_lock = TICKET_LOCK_INIT;
+
+static unsigned int level_shift(unsigned int level)
+{
+    return PAGE_SHIFT + (level - 1) * PT_ORDER;
+}
+
+static unsigned int table_offset(unsigned long linear, unsigned int level)
+{
+    return (linear >> level_shift(level)) & ((PAGE_SIZE / PTE_SIZE) - 1);
+}
+
+static intpte_t *root_table(void)
+{
+    /* 32bit PAE %cr3 points at a 32 byte aligned quad of L3 entries. */
+    unsigned long mask = CONFIG_PAGING_LEVELS == 3 ? ~0x1ful : _u(PAGE_MASK);
+
+    return _p(read_cr3() & mask);
+}
+
+/* Make a leaf entry at @level, from flags in L1 format. */
+static intpte_t make_leaf(paddr_t paddr, uint64_t flags, unsigned int level)
+{
+    if ( level == 1 )
+        return pte_from_paddr(paddr, flags);
+
+    if ( flags & _PAGE_PAT )
+        flags = (flags & ~_PAGE_PAT) | _PAGE_PSE_PAT;
+
+    return pte_from_paddr(paddr, flags | _PAGE_PSE) | (flags & _PAGE_PSE_PAT);
+}
+
+/* Replace the superpage at @pte (at @level) with an equivalent table. */
+static intpte_t *split(intpte_t *pte, unsigned int level)
+{
+    paddr_t base = pte_to_paddr(*pte) & ~(paddr_t)_PAGE_PSE_PAT;
+    uint64_t flags = *pte & ~(PADDR_MASK & PAGE_MASK) & ~_PAGE_PSE;
+    intpte_t *t = alloc_page();
+    unsigned int i;
+
+    if ( !t )
+        return NULL;
+
+    if ( *pte & _PAGE_PSE_PAT )
+        flags |= _PAGE_PAT;
+
+    for ( i = 0; i < PAGE_SIZE / PTE_SIZE; ++i )
+        t[i] = make_leaf(base + ((paddr_t)i << level_shift(level - 1)),
+                         flags, level - 1);
+
+    ACCESS_ONCE(*pte) = pte_from_virt(t, PF_SYM(AD, U, RW, P));
+
+    return t;
+}
+
+/*
+ * Find the entry for @linear at @level.  Superpages above it are split.
+ * Missing tables are allocated if @create, and otherwise, NULL is returned
+ * with *rc as 0.
+ */
+static intpte_t *walk(unsigned long linear, unsigned int level, bool create,
+                      int *rc)
+{
+    intpte_t *t = root_table();
+    unsigned int l;
+
+    for ( l = CONFIG_PAGING_LEVELS; l > level; --l )
+    {
+        intpte_t *pte = &t[table_offset(linear, l)];
+
+        if ( !(*pte & _PAGE_PRESENT) )
+        {
+            *rc = 0;
+            if ( !create )
+                return NULL;
+
+            /* The PAE PDPTEs are cached by the CPU, and all present. */
+            *rc = -EINVAL;
+            if ( CONFIG_PAGING_LEVELS == 3 && l == 3 )
+                return NULL;
+
+            *rc = -ENOMEM;
+            if ( !(t = alloc_page()) )
+                return NULL;
+
+            memset(t, 0, PAGE_SIZE);
+            ACCESS_ONCE(*pte) = pte_from_virt(t, PF_SYM(AD, U, RW, P));
+        }
+        else if ( *pte & _PAGE_PSE )
+        {
+            *rc = -ENOMEM;
+            if ( !(t = split(pte, l)) )
+                return NULL;
+        }
+        else
+            t = _p(pte_to_paddr(*pte));
+    }
+
+    *rc = 0;
+
+    return &t[table_offset(linear, level)];
+}
+
+static void flush_all(void)
+{
+    unsigned long cr4 = read_cr4();
+
+    if ( cr4 & X86_CR4_PGE )
+    {
+        write_cr4(cr4 & ~X86_CR4_PGE);
+        write_cr4(cr4);
+    }
+    else
+        write_cr3(read_cr3());
+}
+
+/* Flush after replacing @old, the entry for @linear at @level. */
+static void flush(unsigned long linear, intpte_t old, unsigned int level)
+{
+    if ( !(old & _PAGE_PRESENT) )
+        return;
+
+    /* A replaced table may have had any mappings beneath it cached. */
+    if ( level == 1 || (old & _PAGE_PSE) )
+        invlpg(_p(linear));
+    else
+        flush_all();
+}
+
+/* Check @order, returning the level it is mapped at, or -errno. */
+static int order_to_level(unsigned int order)
+{
+    if ( order % PT_ORDER )
+        return -EINVAL;
+
+    switch ( order / PT_ORDER )
+    {
+    case 0:
+        return 1;
+
+    case 1:
+        return 2;
+
+    case 2:
+        if ( CONFIG_PAGING_LEVELS == 4 && cpu_has_page1gb )
+            return 3;
+        return -EOPNOTSUPP;
+
+    default:
+        return -EINVAL;
+    }
+}
+
+static int check_flags(uint64_t flags)
+{
+    if ( flags & PADDR_MASK & PAGE_MASK )
+        return -EINVAL;
+
+    if ( CONFIG_PAGING_LEVELS == 2 && (flags >> 32) )
+        return -EINVAL;
+
+    if ( (flags & _PAGE_PKEY(~0u)) && CONFIG_PAGING_LEVELS != 4 )
+        return -EINVAL;
+
+    if ( flags & _PAGE_NX )
+    {
+        uint64_t efer = rdmsr(MSR_EFER);
+
+        if ( !(efer & EFER_NXE) )
+        {
+            if ( !cpu_has_nx )
+                return -EOPNOTSUPP;
+
+            wrmsr(MSR_EFER, efer | EFER_NXE);
+        }
+    }
+
+    return 0;
+}
+
+int hvm_map_pages(unsigned long linear, paddr_t paddr, unsigned int order,
+                  uint64_t flags)
+{
+    int level = order_to_level(order), rc;
+    intpte_t *pte, old;
+
+    if ( level < 0 )
+        return level;
+
+    if ( !IS_ALIGNED(linear, PAGE_SIZE << order) ||
+         !IS_ALIGNED(paddr, PAGE_SIZE << order) ||
+         (CONFIG_PAGING_LEVELS == 2 && (paddr >> 32)) )
+        return -EINVAL;
+
+    if ( (rc = check_flags(flags)) )
+        return rc;
+
+    ticket_spin_lock(&pt_lock);
+
+    if ( (pte = walk(linear, level, true, &rc)) )
+    {
+        old = *pte;
+        ACCESS_ONCE(*pte) = make_leaf(paddr, flags | _PAGE_PRESENT, level);
+        flush(linear, old, level);
+    }
+
+    ticket_spin_unlock(&pt_lock);
+
+    return rc;
+}
+
+int hvm_unmap_pages(unsigned long linear, unsigned int order)
+{
+    int level = order_to_level(order), rc = 0;
+    intpte_t *pte, old;
+
+    if ( level < 0 )
+        return level;
+
+    if ( !IS_ALIGNED(linear, PAGE_SIZE << order) )
+        return -EINVAL;
+
+    ticket_spin_lock(&pt_lock);
+
+    if ( (pte = walk(linear, level, false, &rc)) )
+    {
+        old = *pte;
+        ACCESS_ONCE(*pte) = 0;
+        flush(linear, old, level);
+    }
+
+    ticket_spin_unlock(&pt_lock);
+
+    return rc;
+}
+
+/* Largest order usable at @linear/@paddr, for the @size remaining. */
+static unsigned int range_order(unsigned long linear, paddr_t paddr,
+                                unsigned long size)
+{
+    unsigned int order;
+
+    for ( order = 2 * PT_ORDER; order; order -= PT_ORDER )
+    {
+        unsigned long bytes = PAGE_SIZE << order;
+
+        if ( order_to_level(order) > 0 && IS_ALIGNED(linear | paddr, bytes) &&
+             size >= bytes )
+            break;
+    }
+
+    return order;
+}
+
+int hvm_map_range(unsigned long linear, paddr_t paddr, unsigned long size,
+                  uint64_t flags)
+{
+    if ( !IS_ALIGNED(linear | paddr | size, PAGE_SIZE) )
+        return -EINVAL;
+
+    while ( size )
+    {
+        unsigned int order = range_order(linear, paddr, size);
+        int rc = hvm_map_pages(linear, paddr, order, flags);
+
+        if ( rc )
+            return rc;
+
+        linear += PAGE_SIZE << order;
+        paddr  += PAGE_SIZE << order;
+        size   -= PAGE_SIZE << order;
+    }
+
+    return 0;
+}
+
+int hvm_unmap_range(unsigned long linear, unsigned long size)
+{
+    if ( !IS_ALIGNED(linear | size, PAGE_SIZE) )
+        return -EINVAL;
+
+    while ( size )
+    {
+        unsigned int order = range_order(linear, 0, size);
+        int rc = hvm_unmap_pages(linear, order);
+
+        if ( rc )
+            return rc;
+
+        linear += PAGE_SIZE << order;
+        size   -= PAGE_SIZE << order;
+    }
+
+    return 0;
+}
+
+int hvm_identmap_ram(void)
+{
+#if CONFIG_PAGING_LEVELS == 4
+    uint64_t end = ROUNDUP(hvm_ram_end(), (uint64_t)MB(2));
+
+    end = min(end, (uint64_t)1 << maxphysaddr);
+    if ( end <= GB(4) )
+        return 0;
+
+    return hvm_map_range(GB(4), GB(4), end - GB(4), PF_SYM(AD, RW));
+#else
+    return -EOPNOTSUPP;
+#endif
+}
+
+#else /* CONFIG_PAGING_LEVELS > 0 */
+
+int hvm_map_pages(unsigned long linear, paddr_t paddr, unsigned int order,
+                  uint64_t flags)
+{
+    return -EOPNOTSUPP;
+}
+
+int hvm_unmap_pages(unsigned long linear, unsigned int order)
+{
+    return -EOPNOTSUPP;
+}
+
+int hvm_map_range(unsigned long linear, paddr_t paddr, unsigned long size,
+                  uint64_t flags)
+{
+    return -EOPNOTSUPP;
+}
+
+int hvm_unmap_range(unsigned long linear, unsigned long size)
+{
+    return -EOPNOTSUPP;
+}
+
+int hvm_identmap_ram(void)
+{
+    return -EOPNOTSUPP;
+}
+
+#endif /* CONFIG_PAGING_LEVELS > 0 */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
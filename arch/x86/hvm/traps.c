@@ -1,5 +1,6 @@
 #include <xtf/traps.h>
 #include <xtf/lib.h>
+#include <xtf/smp.h>
 
 #include <arch/idt.h>
 #include <arch/lib.h>
@@ -70,6 +71,10 @@ static env_tss tss_DF __aligned(16) =
     .iopb = X86_TSS_INVALID_IO_BITMAP,
 };
 
+/* Per-AP copies of gdt[] and tss, differing only in the stacks used. */
+static user_desc ap_gdt[NR_CPUS][NR_GDT_ENTRIES] __aligned(16);
+static env_tss ap_tss[NR_CPUS] __aligned(16);
+
 int xtf_set_idte(unsigned int vector, const struct xtf_idte *idte)
 {
     pack_intr_gate(&idt[vector], idte->cs, idte->addr, idte->dpl, 0);
@@ -139,6 +144,33 @@ void arch_init_traps(void)
                virt_to_gfn(__end_user_bss));
 }
 
+void arch_init_ap_traps(unsigned int cpu, uint8_t *stack)
+{
+    user_desc *ap_gdtp = ap_gdt[cpu];
+    env_tss *ap_tssp = &ap_tss[cpu];
+    desc_ptr ap_gdt_ptr = {
+        .limit = sizeof(gdt) - 1,
+        .base = _u(ap_gdtp),
+    };
+
+    memcpy(ap_gdtp, gdt, sizeof(gdt));
+    *ap_tssp = tss;
+
+#if defined(__i386__)
+    ap_tssp->esp0   = _u(&stack[2 * PAGE_SIZE]);
+#elif defined(__x86_64__)
+    ap_tssp->rsp0   = _u(&stack[2 * PAGE_SIZE]);
+    ap_tssp->ist[0] = _u(&stack[3 * PAGE_SIZE]);
+#endif
+
+    /* Replaces the BSP's busy TSS descriptor. */
+    pack_tss_desc(&ap_gdtp[GDTE_TSS], ap_tssp);
+
+    lgdt(&ap_gdt_ptr);
+    lidt(&idt_ptr);
+    ltr(GDTE_TSS * 8);
+}
+
 void __noreturn arch_crash_hard(void)
 {
     /*
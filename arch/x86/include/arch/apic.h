@@ -18,6 +18,8 @@
 /* Local APIC register definitions. */
 #define APIC_ID         0x020
 #define APIC_LVR        0x030
+#define APIC_TASKPRI    0x080
+#define APIC_EOI        0x0b0
 #define APIC_SPIV       0x0f0
 #define   APIC_SPIV_APIC_ENABLED  0x00100
 
@@ -32,7 +34,16 @@
 #define   APIC_DEST_SELF          0x40000
 
 #define APIC_ICR2       0x310
+#define APIC_LVTT       0x320
+#define   APIC_LVT_MASKED         0x10000
+#define   APIC_TIMER_ONESHOT      0x00000
+#define   APIC_TIMER_TSC_DEADLINE 0x40000
+
 #define APIC_LVTERR     0x370
+#define APIC_TMICT      0x380
+#define APIC_TMCCT      0x390
+#define APIC_TDCR       0x3e0
+#define   APIC_TDR_DIV_1          0x0000b
 
 #define APIC_DEFAULT_BASE 0xfee00000ul
 
@@ -52,6 +63,12 @@ enum apic_mode {
  */
 int apic_init(enum apic_mode mode);
 
+/**
+ * Initialise the calling AP's local APIC to the mode chosen by apic_init() on
+ * the BSP.  Each vCPU has its own local APIC.
+ */
+int apic_init_ap(void);
+
 static inline uint32_t apic_mmio_read(unsigned int reg)
 {
     return *(volatile uint32_t *)(_p(APIC_DEFAULT_BASE) + reg);
@@ -126,6 +143,21 @@ static inline void apic_icr_write(uint64_t val)
         return apic_msr_icr_write(val);
 }
 
+/** The calling vCPU's local APIC ID. */
+static inline uint32_t apic_get_id(void)
+{
+    uint32_t id = apic_read(APIC_ID);
+
+    return CUR_APIC_MODE == APIC_MODE_XAPIC ? id >> 24 : id;
+}
+
+/** ICR destination field for the local APIC with ID @p id. */
+static inline uint64_t apic_icr_dest(uint32_t id)
+{
+    return CUR_APIC_MODE == APIC_MODE_XAPIC ? (uint64_t)(id << 24) << 32
+                                            : (uint64_t)id << 32;
+}
+
 #endif /* XTF_X86_APIC_H */
 
 /*
@@ -0,0 +1,202 @@
+/**
+ * @file arch/x86/include/arch/atomic.h
+ *
+ * Typed atomic operations.
+ *
+ * All read-modify-write operations are `lock`ed, and therefore full
+ * barriers.
+ */
+#ifndef XTF_X86_ATOMIC_H
+#define XTF_X86_ATOMIC_H
+
+#include <xtf/lib.h>
+
+typedef struct { int counter; } atomic_t;
+typedef struct { int64_t counter; } __aligned(8) atomic64_t;
+
+#define ATOMIC_INIT(i)   { (i) }
+#define ATOMIC64_INIT(i) { (i) }
+
+/**
+ * Compare and exchange 8 bytes at @p ptr.
+ *
+ * @returns the previous value.  The exchange occurred if it equals @p old.
+ */
+static inline uint64_t cmpxchg8b(volatile void *ptr, uint64_t old,
+                                 uint64_t new)
+{
+    uint32_t lo = old, hi = old >> 32;
+
+    asm volatile ("lock cmpxchg8b %[ptr]"
+                  : [ptr] "+m" (*(volatile uint64_t *)ptr),
+                    "+a" (lo), "+d" (hi)
+                  : "b" ((uint32_t)new), "c" ((uint32_t)(new >> 32))
+                  : "memory");
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#ifdef __x86_64__
+/**
+ * Compare and exchange 16 bytes at @p ptr, which must be 16-byte aligned.
+ * Requires `cpu_has_cx16`.
+ *
+ * @returns the previous value.  The exchange occurred if it equals @p old.
+ */
+static inline unsigned __int128 cmpxchg16b(volatile void *ptr,
+                                           unsigned __int128 old,
+                                           unsigned __int128 new)
+{
+    uint64_t lo = old, hi = old >> 64;
+
+    asm volatile ("lock cmpxchg16b %[ptr]"
+                  : [ptr] "+m" (*(volatile unsigned __int128 *)ptr),
+                    "+a" (lo), "+d" (hi)
+                  : "b" ((uint64_t)new), "c" ((uint64_t)(new >> 64))
+                  : "memory");
+
+    return ((unsigned __int128)hi << 64) | lo;
+}
+#endif
+
+static inline int atomic_read(const atomic_t *v)
+{
+    return ACCESS_ONCE(v->counter);
+}
+
+static inline void atomic_set(atomic_t *v, int i)
+{
+    ACCESS_ONCE(v->counter) = i;
+}
+
+/** Add @p i to @p v, returning the previous value. */
+static inline int atomic_fetch_add(atomic_t *v, int i)
+{
+    asm volatile ("lock xadd %[i], %[ctr]"
+                  : [i] "+r" (i), [ctr] "+m" (v->counter)
+                  :: "memory");
+
+    return i;
+}
+
+static inline void atomic_inc(atomic_t *v)
+{
+    asm volatile ("lock incl %[ctr]" : [ctr] "+m" (v->counter) :: "memory");
+}
+
+static inline void atomic_dec(atomic_t *v)
+{
+    asm volatile ("lock decl %[ctr]" : [ctr] "+m" (v->counter) :: "memory");
+}
+
+/** Set @p v to @p new, returning the previous value. */
+static inline int atomic_xchg(atomic_t *v, int new)
+{
+    asm volatile ("xchg %[new], %[ctr]"
+                  : [new] "+r" (new), [ctr] "+m" (v->counter)
+                  :: "memory");
+
+    return new;
+}
+
+/**
+ * Set @p v to @p new if it equals @p old.
+ *
+ * @returns the previous value.  The exchange occurred if it equals @p old.
+ */
+static inline int atomic_cmpxchg(atomic_t *v, int old, int new)
+{
+    asm volatile ("lock cmpxchg %[new], %[ctr]"
+                  : "+a" (old), [ctr] "+m" (v->counter)
+                  : [new] "r" (new)
+                  : "memory");
+
+    return old;
+}
+
+/*
+ * 64bit atomics use native instructions in 64bit builds, and are built on
+ * cmpxchg8b in 32bit builds.
+ */
+static inline int64_t atomic64_cmpxchg(atomic64_t *v, int64_t old,
+                                       int64_t new)
+{
+#ifdef __x86_64__
+    asm volatile ("lock cmpxchg %[new], %[ctr]"
+                  : "+a" (old), [ctr] "+m" (v->counter)
+                  : [new] "r" (new)
+                  : "memory");
+
+    return old;
+#else
+    return cmpxchg8b(&v->counter, old, new);
+#endif
+}
+
+static inline int64_t atomic64_read(const atomic64_t *v)
+{
+#ifdef __x86_64__
+    return ACCESS_ONCE(v->counter);
+#else
+    /* Either fails, or rewrites the same value.  Both are atomic reads. */
+    return cmpxchg8b((void *)&v->counter, 0, 0);
+#endif
+}
+
+static inline int64_t atomic64_xchg(atomic64_t *v, int64_t new)
+{
+#ifdef __x86_64__
+    asm volatile ("xchg %[new], %[ctr]"
+                  : [new] "+r" (new), [ctr] "+m" (v->counter)
+                  :: "memory");
+
+    return new;
+#else
+    int64_t old = v->counter, prev;
+
+    while ( (prev = atomic64_cmpxchg(v, old, new)) != old )
+        old = prev;
+
+    return old;
+#endif
+}
+
+static inline void atomic64_set(atomic64_t *v, int64_t i)
+{
+#ifdef __x86_64__
+    ACCESS_ONCE(v->counter) = i;
+#else
+    atomic64_xchg(v, i);
+#endif
+}
+
+/** Add @p i to @p v, returning the previous value. */
+static inline int64_t atomic64_fetch_add(atomic64_t *v, int64_t i)
+{
+#ifdef __x86_64__
+    asm volatile ("lock xadd %[i], %[ctr]"
+                  : [i] "+r" (i), [ctr] "+m" (v->counter)
+                  :: "memory");
+
+    return i;
+#else
+    int64_t old = v->counter, prev;
+
+    while ( (prev = atomic64_cmpxchg(v, old, old + i)) != old )
+        old = prev;
+
+    return old;
+#endif
+}
+
+#endif /* XTF_X86_ATOMIC_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
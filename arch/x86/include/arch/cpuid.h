@@ -25,6 +25,12 @@ extern unsigned int max_leaf, max_extd_leaf;
 extern unsigned int x86_family, x86_model, x86_stepping;
 extern unsigned int maxphysaddr, maxvirtaddr;
 
+/**
+ * Locate the base of the Xen CPUID leaves (0x4000_0000 or 0x4000_0100).
+ * Panics if they can't be found.
+ */
+unsigned int find_xen_leaves(void);
+
 static inline bool vendor_is(enum x86_vendor v)
 {
     return x86_vendor == v;
@@ -77,8 +83,10 @@ static inline bool cpu_has(unsigned int feature)
 #define cpu_has_sse2            cpu_has(X86_FEATURE_SSE2)
 #define cpu_has_vmx             cpu_has(X86_FEATURE_VMX)
 #define cpu_has_smx             cpu_has(X86_FEATURE_SMX)
+#define cpu_has_cx16            cpu_has(X86_FEATURE_CX16)
 #define cpu_has_pcid            cpu_has(X86_FEATURE_PCID)
 #define cpu_has_x2apic          cpu_has(X86_FEATURE_X2APIC)
+#define cpu_has_tsc_deadline    cpu_has(X86_FEATURE_TSC_DEADLINE)
 #define cpu_has_xsave           cpu_has(X86_FEATURE_XSAVE)
 #define cpu_has_avx             cpu_has(X86_FEATURE_AVX)
 
@@ -93,12 +101,14 @@ static inline bool cpu_has(unsigned int feature)
 #define cpu_has_fsgsbase        cpu_has(X86_FEATURE_FSGSBASE)
 #define cpu_has_hle             cpu_has(X86_FEATURE_HLE)
 #define cpu_has_smep            cpu_has(X86_FEATURE_SMEP)
+#define cpu_has_erms            cpu_has(X86_FEATURE_ERMS)
 #define cpu_has_rtm             cpu_has(X86_FEATURE_RTM)
 #define cpu_has_smap            cpu_has(X86_FEATURE_SMAP)
 
 #define cpu_has_umip            cpu_has(X86_FEATURE_UMIP)
 #define cpu_has_pku             cpu_has(X86_FEATURE_PKU)
 
+#define cpu_has_fsrm            cpu_has(X86_FEATURE_FSRM)
 #define cpu_has_rtm_always_abort cpu_has(X86_FEATURE_RTM_ALWAYS_ABORT)
 
 #endif /* XTF_X86_CPUID_H */
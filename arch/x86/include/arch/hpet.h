@@ -23,6 +23,7 @@
 #define HPET_COUNTER            0x0f0
 
 #define HPET_Tn_CFG(n)         (0x100 + (n) * 0x20)
+#define HPET_Tn_ROUTE_CAP(n)   (0x104 + (n) * 0x20)
 
 #define HPET_Tn_CMP(n)         (0x108 + (n) * 0x20)
 
@@ -31,6 +32,9 @@
 /* Number of available HPET timers. */
 extern unsigned int hpet_nr_timers;
 
+/* Main counter tick period, in femtoseconds. */
+extern uint32_t hpet_period;
+
 /**
  * Discover and initialise the HPET.  May fail if there is no HPET.
  */
@@ -24,6 +24,7 @@
 #define   IOAPIC_MAXREDIR_MASK    0xff0000
 
 #define IOAPIC_REDIR_ENTRY(e)     (0x10 + (e) * 2)
+#define   IOAPIC_REDIR_LEVEL_SHIFT 15
 #define   IOAPIC_REDIR_MASK_SHIFT 16
 
 #define IOAPIC_DEFAULT_BASE       0xfec00000
@@ -62,6 +63,12 @@ static inline void ioapic_write64(unsigned int reg, uint64_t val)
  */
 int ioapic_set_mask(unsigned int entry, bool mask);
 
+/**
+ * Route a redirection entry as a fixed interrupt to @p vector on APIC ID 0.
+ * The entry is left masked.
+ */
+int ioapic_set_redir(unsigned int entry, unsigned int vector, bool level);
+
 #endif /* !XTF_X86_IO_APIC_H */
 
 /*
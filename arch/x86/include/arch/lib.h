@@ -128,6 +128,33 @@ static inline void rep_outsb(const char *buf, size_t len, uint16_t port)
                   : "d" (port) );
 }
 
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/*
+ * `rdtsc` which is ordered after all earlier instructions have completed.
+ * Suitable for bracketing a region being timed.
+ */
+static inline uint64_t rdtsc_ordered(void)
+{
+    uint32_t lo, hi;
+
+    asm volatile ("lfence; rdtsc" : "=a" (lo), "=d" (hi) :: "memory");
+
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void cpu_relax(void)
+{
+    asm volatile ("pause" ::: "memory");
+}
+
 static inline unsigned int read_cs(void)
 {
     unsigned int cs;
@@ -31,7 +31,8 @@
  * contiguous in the pagetables created by the domain builder.  Therefore,
  * virt == pfn << PAGE_SHIFT for any pfn constructed by the domain builder.
  *
- * HVM guests: All memory from 0 to 4GB is identity mapped.
+ * HVM guests: All memory from 0 to 4GB is identity mapped.  64bit guests can
+ * extend the identity map to all RAM with hvm_identmap_ram().
  */
 
 static inline void *pfn_to_virt(unsigned long pfn)
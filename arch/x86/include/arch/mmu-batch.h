@@ -0,0 +1,81 @@
+/**
+ * @file arch/x86/include/arch/mmu-batch.h
+ *
+ * Batching of PV pagetable updates.
+ *
+ * `mmu_update` requests, `update_va_mapping` requests and `mmuext_op`
+ * operations are queued in order, and submitted together as a single
+ * hypercall, or a `multicall` of several, when the batch fills, or at
+ * mmu_batch_flush().  Consecutive `mmu_update` requests share one hypercall,
+ * as do consecutive `mmuext_op` operations.  `update_va_mapping` takes a
+ * single PTE, so each costs a hypercall of its own; prefer
+ * mmu_batch_update() against the L1 entry for runs of PTEs.
+ *
+ * TLB flushing is deferred to mmu_batch_flush().  Repeated invalidations
+ * of the same address are merged, and too many distinct addresses become a
+ * single full flush.  Only the current vCPU's TLB is flushed.  New mappings
+ * must not be relied upon until mmu_batch_flush() has returned.
+ *
+ * Errors are sticky, and reported by mmu_batch_flush().  A batch is large,
+ * and best given static storage.  PV only.
+ */
+#ifndef XTF_X86_MMU_BATCH_H
+#define XTF_X86_MMU_BATCH_H
+
+#include <xtf/types.h>
+
+#include <xen/xen.h>
+
+#define MMU_BATCH_CALLS  16 /**< Hypercalls in one multicall.            */
+#define MMU_BATCH_MU     64 /**< Queued mmu_update requests.             */
+#define MMU_BATCH_EXT    16 /**< Queued mmuext_op operations.            */
+#define MMU_BATCH_INVLPG 8  /**< Distinct invlpgs before a full flush.   */
+
+struct mmu_batch
+{
+    multicall_entry_t calls[MMU_BATCH_CALLS];
+    mmu_update_t mu[MMU_BATCH_MU];
+    mmuext_op_t ext[MMU_BATCH_EXT];
+    unsigned long invlpg[MMU_BATCH_INVLPG];
+    unsigned int nr_calls, nr_mu, nr_ext, nr_invlpg;
+    bool flush_all;
+    int rc;
+};
+
+/** Prepare @p b for use. */
+void mmu_batch_init(struct mmu_batch *b);
+
+/** Queue an `mmu_update` of the PTE at machine address @p ptr. */
+void mmu_batch_update(struct mmu_batch *b, uint64_t ptr, uint64_t val);
+
+/** Queue an `update_va_mapping` of @p linear, and an invlpg of it. */
+void mmu_batch_update_va(struct mmu_batch *b, unsigned long linear,
+                         uint64_t pte);
+
+/** Queue an `mmuext_op`.  Use the helpers below for TLB flushes. */
+void mmu_batch_ext(struct mmu_batch *b, const mmuext_op_t *op);
+
+/** Request an invalidation of @p linear at the next flush. */
+void mmu_batch_invlpg(struct mmu_batch *b, unsigned long linear);
+
+/** Request a full TLB flush at the next flush. */
+void mmu_batch_flush_tlb(struct mmu_batch *b);
+
+/**
+ * Submit everything queued, followed by the merged TLB flush.
+ *
+ * @returns 0, or the first error since the previous flush.
+ */
+int mmu_batch_flush(struct mmu_batch *b);
+
+#endif /* XTF_X86_MMU_BATCH_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -96,6 +96,9 @@
 typedef uint64_t paddr_t;
 #define PRIpaddr "016"PRIx64
 
+/* Protection key, in bits 62:59 of a leaf PTE.  4-level paging only. */
+#define _PAGE_PKEY(k)           (((uint64_t)(k) & 0xf) << 59)
+
 #if CONFIG_PAGING_LEVELS > 0 /* Some form of pagetables. */
 
 #if CONFIG_PAGING_LEVELS == 2 /* PSE Paging */
@@ -36,6 +36,59 @@ intpte_t pte_from_virt(const void *va, uint64_t flags);
 
 #endif
 
+/*
+ * Runtime construction of mappings in the live HVM pagetables.
+ *
+ * @p flags are given in L1 format (#_PAGE_PAT in bit 7), and are converted
+ * for superpages.  #_PAGE_PRESENT is implied.  #_PAGE_NX turns on EFER.NXE
+ * for the current vCPU, and #_PAGE_PKEY() needs 4-level paging.
+ *
+ * Orders are #PAGE_ORDER_4K, a superpage (#PAGE_ORDER_2M with PAE paging,
+ * #PAGE_ORDER_4M with PSE paging), or #PAGE_ORDER_1G with 4-level paging on
+ * hardware which supports it.  Missing tables are taken from alloc_page(),
+ * and superpages are split into tables as needed.  Tables are never freed.
+ *
+ * Only the current vCPU's TLB is flushed.  All return 0 or -errno, and
+ * -EOPNOTSUPP in unpaged environments.
+ */
+
+/** Map 2^@p order pages at @p linear to @p paddr. */
+int hvm_map_pages(unsigned long linear, paddr_t paddr, unsigned int order,
+                  uint64_t flags);
+
+/** Unmap 2^@p order pages at @p linear. */
+int hvm_unmap_pages(unsigned long linear, unsigned int order);
+
+/** Map @p size bytes, using the largest pages alignment permits. */
+int hvm_map_range(unsigned long linear, paddr_t paddr, unsigned long size,
+                  uint64_t flags);
+
+/** Unmap @p size bytes at @p linear. */
+int hvm_unmap_range(unsigned long linear, unsigned long size);
+
+/** End of the highest RAM region in the guest's memory map. */
+uint64_t hvm_ram_end(void);
+
+/**
+ * Extend the identity map beyond 4G, to cover all RAM, using 1G pages where
+ * available.  Not done by default, as tests use the L3 slots above 4G for
+ * their own mappings.  4-level paging only.
+ */
+int hvm_identmap_ram(void);
+
+/*
+ * PV pagetable access.  The pagetables are mapped read-only, but once
+ * pv_writable_pagetables() has succeeded, the L1 entries returned by
+ * pv_l1e() may be written directly, with each write trapping to Xen to be
+ * validated and emulated.
+ */
+
+/** Find the L1 entry mapping @p linear, or NULL if there isn't one. */
+intpte_t *pv_l1e(unsigned long linear);
+
+/** Enable `VMASST_TYPE_writable_pagetables`.  Returns 0 or -errno. */
+int pv_writable_pagetables(void);
+
 #endif /* XTF_X86_PAGETABLE_H */
 
 /*
@@ -14,6 +14,18 @@
  */
 void arch_init_traps(void);
 
+/*
+ * Arch-specific function to initialise an AP's exception handling, to match
+ * the BSP.  @stack is the base of the AP's stack, laid out like boot_stack[].
+ */
+void arch_init_ap_traps(unsigned int cpu, uint8_t *stack);
+
+/*
+ * Register runstate[@cpu] with Xen.  Failure is reported, and leaves
+ * runstate_registered[@cpu] clear.
+ */
+void register_runstate_area(unsigned int cpu);
+
 /*
  * Return the correct %ss/%esp from an exception.  In 32bit if no stack switch
  * occurs, an exception frame doesn't contain this information.
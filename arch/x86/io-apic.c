@@ -42,6 +42,21 @@ int ioapic_set_mask(unsigned int entry, bool mask)
     return 0;
 }
 
+int ioapic_set_redir(unsigned int entry, unsigned int vector, bool level)
+{
+    uint64_t redir = (vector & 0xff) | (1ull << IOAPIC_REDIR_MASK_SHIFT);
+
+    if ( entry >= nr_entries )
+        return -EINVAL;
+
+    if ( level )
+        redir |= 1ull << IOAPIC_REDIR_LEVEL_SHIFT;
+
+    ioapic_write64(IOAPIC_REDIR_ENTRY(entry), redir);
+
+    return 0;
+}
+
 /*
  * Local variables:
  * mode: C
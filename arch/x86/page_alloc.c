@@ -0,0 +1,251 @@
+/**
+ * @file arch/x86/page_alloc.c
+ *
+ * Discovery of free memory for the page allocator.
+ */
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/page_alloc.h>
+
+#include <arch/mm.h>
+#include <arch/pagetable.h>
+#include <arch/symbolic-const.h>
+#include <arch/xtf.h>
+
+#if defined(CONFIG_HVM)
+
+/* Frames reserved within RAM: the test image, and the start info. */
+static struct
+{
+    unsigned long start, end;
+} reserved[8];
+static unsigned int nr_reserved;
+
+static void reserve(uint64_t paddr, uint64_t len)
+{
+    if ( !len )
+        return;
+
+    if ( nr_reserved == ARRAY_SIZE(reserved) )
+        panic("page_alloc: Too many reserved regions\n");
+
+    reserved[nr_reserved].start = paddr >> PAGE_SHIFT;
+    reserved[nr_reserved].end = (paddr + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    nr_reserved++;
+}
+
+/* Add [start, end), excluding reserved[idx] onwards. */
+static void add_free(unsigned long start, unsigned long end, unsigned int idx)
+{
+    for ( ; idx < nr_reserved; ++idx )
+    {
+        if ( reserved[idx].end <= start || reserved[idx].start >= end )
+            continue;
+
+        if ( start < reserved[idx].start )
+            add_free(start, reserved[idx].start, idx + 1);
+        if ( reserved[idx].end < end )
+            add_free(reserved[idx].end, end, idx + 1);
+
+        return;
+    }
+
+    page_alloc_add_range(start, end);
+}
+
+/* Only the first 4G is identity mapped. */
+static void add_ram(uint64_t addr, uint64_t size)
+{
+    uint64_t start = (addr + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    uint64_t end = min(addr + size, (uint64_t)GB(4)) >> PAGE_SHIFT;
+
+    if ( start < end )
+        add_free(start, end, 0);
+}
+
+/* Call @fn for each RAM region, from the PVH memmap or XENMEM_memory_map. */
+static void for_each_ram(void (*fn)(uint64_t addr, uint64_t size))
+{
+    static struct e820entry map[32];
+    struct xen_memory_map memmap = {
+        .nr_entries = ARRAY_SIZE(map),
+        .buffer = map,
+    };
+    const xen_pvh_start_info_t *si = pvh_start_info;
+    unsigned int i;
+
+    if ( si && si->version >= 1 && si->memmap_entries )
+    {
+        const struct xen_hvm_memmap_table_entry *ent = _p(si->memmap_paddr);
+
+        for ( i = 0; i < si->memmap_entries; ++i )
+            if ( ent[i].type == XEN_HVM_MEMMAP_TYPE_RAM )
+                fn(ent[i].addr, ent[i].size);
+
+        return;
+    }
+
+    if ( hypercall_memory_op(XENMEM_memory_map, &memmap) )
+    {
+        printk("No memory map available\n");
+        return;
+    }
+
+    for ( i = 0; i < memmap.nr_entries; ++i )
+        if ( map[i].type == E820_RAM )
+            fn(map[i].addr, map[i].size);
+}
+
+void arch_page_alloc_init(void)
+{
+    const xen_pvh_start_info_t *si = pvh_start_info;
+    unsigned int i;
+
+    /* Everything up to the end of the image, including the low 1M. */
+    reserve(0, _u(_end));
+
+    if ( si )
+    {
+        const struct xen_hvm_modlist_entry *mod = _p(si->modlist_paddr);
+
+        reserve(_u(si), sizeof(*si));
+        if ( si->cmdline_paddr )
+            reserve(si->cmdline_paddr, PAGE_SIZE);
+        reserve(si->modlist_paddr, si->nr_modules * sizeof(*mod));
+        for ( i = 0; i < si->nr_modules; ++i )
+            reserve(mod[i].paddr, mod[i].size);
+
+        if ( si->version >= 1 )
+            reserve(si->memmap_paddr, si->memmap_entries *
+                    sizeof(struct xen_hvm_memmap_table_entry));
+    }
+
+    for_each_ram(add_ram);
+}
+
+static uint64_t ram_end;
+
+static void note_ram_end(uint64_t addr, uint64_t size)
+{
+    ram_end = max(ram_end, addr + size);
+}
+
+uint64_t hvm_ram_end(void)
+{
+    ram_end = 0;
+    for_each_ram(note_ram_end);
+
+    return ram_end;
+}
+
+int page_set_guard(void *va, bool guard)
+{
+    if ( guard )
+        return hvm_unmap_pages(_u(va), PAGE_ORDER_4K);
+
+    return hvm_map_pages(_u(va), _u(va), PAGE_ORDER_4K, PF_SYM(AD, RW));
+}
+
+#else /* CONFIG_HVM */
+
+/* Extra frames are only mapped within the 1G covered by the initial L2. */
+#define PV_LIMIT_PFN (GB(1) >> PAGE_SHIFT)
+
+static unsigned long pfn_after(const void *va, unsigned long len)
+{
+    return (_u(va) + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+}
+
+void arch_page_alloc_init(void)
+{
+    const xen_pv_start_info_t *si = pv_start_info;
+    unsigned long start, boot_end, end, l1_pfn, nr_l1, mapped, i, j;
+    intpte_t *l2t;
+
+    /*
+     * The domain builder lays out the image, p2m, start info, pagetables and
+     * a bootstrap stack page contiguously, then pads the initial mapping by
+     * at least 512k, to a 4M boundary.
+     */
+    start = pfn_after(_end, 0);
+    start = max(start, pfn_after(_p(si->mfn_list),
+                                 si->nr_pages * sizeof(unsigned long)));
+    start = max(start, pfn_after(si, sizeof(*si)));
+    start = max(start, pfn_after(mfn_to_virt(si->store_mfn), PAGE_SIZE));
+    start = max(start, pfn_after(mfn_to_virt(si->console.domU.mfn),
+                                 PAGE_SIZE));
+    start = max(start, pfn_after(_p(si->pt_base),
+                                 si->nr_pt_frames << PAGE_SHIFT));
+    start += 1; /* Bootstrap stack. */
+
+    end = min(si->nr_pages, (unsigned long)PV_LIMIT_PFN);
+    boot_end = ROUNDUP(start + (KB(512) >> PAGE_SHIFT),
+                       MB(4) >> PAGE_SHIFT);
+    boot_end = min(boot_end, end);
+
+    if ( start >= boot_end )
+        return;
+
+    /* Take L1 tables from the padding, to map the rest 2M at a time. */
+    nr_l1 = (end - boot_end + L1_PT_ENTRIES - 1) / L1_PT_ENTRIES;
+    nr_l1 = min(nr_l1, boot_end - start - 1);
+    l1_pfn = start;
+
+    if ( IS_DEFINED(CONFIG_64BIT) )
+    {
+        intpte_t *l4t = _p(si->pt_base);
+        intpte_t *l3t = maddr_to_virt(pte_to_paddr(l4t[0]));
+
+        l2t = maddr_to_virt(pte_to_paddr(l3t[0]));
+    }
+    else
+    {
+        intpte_t *l3t = _p(si->pt_base);
+
+        l2t = maddr_to_virt(pte_to_paddr(l3t[0]));
+    }
+
+    for ( i = 0, mapped = boot_end; i < nr_l1; ++i, mapped += L1_PT_ENTRIES )
+    {
+        intpte_t *l1t = pfn_to_virt(l1_pfn + i);
+        unsigned int slot = l2_table_offset(mapped << PAGE_SHIFT);
+        mmu_update_t mu;
+
+        if ( l2t[slot] & _PAGE_PRESENT )
+            panic("page_alloc: L2[%u] unexpectedly present\n", slot);
+
+        for ( j = 0; j < L1_PT_ENTRIES; ++j )
+            l1t[j] = (mapped + j < end)
+                ? pte_from_gfn(pfn_to_mfn(mapped + j), PF_SYM(AD, RW, P)) : 0;
+
+        if ( hypercall_update_va_mapping(
+                 _u(l1t), pte_from_virt(l1t, PF_SYM(AD, P)), UVMF_INVLPG) )
+            break;
+
+        mu.ptr = virt_to_maddr(&l2t[slot]);
+        mu.val = pte_from_virt(l1t, PF_SYM(AD, RW, P));
+
+        if ( hypercall_mmu_update(&mu, 1, NULL, DOMID_SELF) )
+            panic("page_alloc: Failed to map L1 for pfn %#lx\n", mapped);
+    }
+
+    page_alloc_add_range(l1_pfn + i, min(mapped, end));
+}
+
+int page_set_guard(void *va, bool guard)
+{
+    return hypercall_update_va_mapping(
+        _u(va), guard ? 0 : pte_from_virt(va, PF_SYM(AD, RW, P)), UVMF_INVLPG);
+}
+
+#endif /* CONFIG_HVM */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
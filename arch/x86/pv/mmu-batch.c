@@ -0,0 +1,206 @@
+/**
+ * @file arch/x86/pv/mmu-batch.c
+ *
+ * Batching of PV pagetable updates.
+ */
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+
+#include <arch/mmu-batch.h>
+
+void mmu_batch_init(struct mmu_batch *b)
+{
+    b->nr_calls = b->nr_mu = b->nr_ext = b->nr_invlpg = 0;
+    b->flush_all = false;
+    b->rc = 0;
+}
+
+static long single_call(const multicall_entry_t *mc)
+{
+    switch ( mc->op )
+    {
+    case __HYPERVISOR_mmu_update:
+        return hypercall_mmu_update(_p(mc->args[0]), mc->args[1],
+                                    NULL, DOMID_SELF);
+
+    case __HYPERVISOR_mmuext_op:
+        return hypercall_mmuext_op(_p(mc->args[0]), mc->args[1],
+                                   NULL, DOMID_SELF);
+
+    case __HYPERVISOR_update_va_mapping:
+#ifdef __x86_64__
+        return hypercall_update_va_mapping(mc->args[0], mc->args[1],
+                                           mc->args[2]);
+#else
+        return hypercall_update_va_mapping(
+            mc->args[0], mc->args[1] | ((uint64_t)mc->args[2] << 32),
+            mc->args[3]);
+#endif
+
+    default:
+        return -EINVAL;
+    }
+}
+
+/* Submit the queued hypercalls, without any pending TLB flush. */
+static void submit(struct mmu_batch *b)
+{
+    long rc = 0;
+    unsigned int i;
+
+    if ( b->nr_calls == 1 )
+        rc = single_call(&b->calls[0]);
+    else if ( b->nr_calls > 1 )
+    {
+        rc = hypercall_multicall(b->calls, b->nr_calls);
+
+        for ( i = 0; !rc && i < b->nr_calls; ++i )
+            rc = b->calls[i].result;
+    }
+
+    if ( rc && !b->rc )
+        b->rc = rc;
+
+    b->nr_calls = b->nr_mu = b->nr_ext = 0;
+}
+
+/*
+ * Find the call to append a request of type @op to, or start a new one.
+ * @full indicates that the request array for @op is full.
+ */
+static multicall_entry_t *get_call(struct mmu_batch *b, unsigned long op,
+                                   bool full)
+{
+    multicall_entry_t *mc = b->nr_calls ? &b->calls[b->nr_calls - 1] : NULL;
+    bool extend = mc && mc->op == op && op != __HYPERVISOR_update_va_mapping;
+
+    if ( full || (!extend && b->nr_calls == MMU_BATCH_CALLS) )
+    {
+        submit(b);
+        extend = false;
+    }
+
+    if ( extend )
+        return mc;
+
+    mc = &b->calls[b->nr_calls++];
+    memset(mc, 0, sizeof(*mc));
+    mc->op = op;
+
+    return mc;
+}
+
+void mmu_batch_update(struct mmu_batch *b, uint64_t ptr, uint64_t val)
+{
+    multicall_entry_t *mc = get_call(b, __HYPERVISOR_mmu_update,
+                                     b->nr_mu == MMU_BATCH_MU);
+
+    if ( !mc->args[1]++ )
+    {
+        mc->args[0] = _u(&b->mu[b->nr_mu]);
+        mc->args[3] = DOMID_SELF;
+    }
+
+    b->mu[b->nr_mu++] = (mmu_update_t){ .ptr = ptr, .val = val };
+}
+
+void mmu_batch_ext(struct mmu_batch *b, const mmuext_op_t *op)
+{
+    multicall_entry_t *mc = get_call(b, __HYPERVISOR_mmuext_op,
+                                     b->nr_ext == MMU_BATCH_EXT);
+
+    if ( !mc->args[1]++ )
+    {
+        mc->args[0] = _u(&b->ext[b->nr_ext]);
+        mc->args[3] = DOMID_SELF;
+    }
+
+    b->ext[b->nr_ext++] = *op;
+}
+
+void mmu_batch_update_va(struct mmu_batch *b, unsigned long linear,
+                         uint64_t pte)
+{
+    multicall_entry_t *mc = get_call(b, __HYPERVISOR_update_va_mapping,
+                                     false);
+
+    mc->args[0] = linear;
+#ifdef __x86_64__
+    mc->args[1] = pte;
+    mc->args[2] = UVMF_NONE;
+#else
+    mc->args[1] = pte;
+    mc->args[2] = pte >> 32;
+    mc->args[3] = UVMF_NONE;
+#endif
+
+    mmu_batch_invlpg(b, linear);
+}
+
+void mmu_batch_invlpg(struct mmu_batch *b, unsigned long linear)
+{
+    unsigned int i;
+
+    if ( b->flush_all )
+        return;
+
+    linear &= PAGE_MASK;
+
+    for ( i = 0; i < b->nr_invlpg; ++i )
+        if ( b->invlpg[i] == linear )
+            return;
+
+    if ( b->nr_invlpg == MMU_BATCH_INVLPG )
+        b->flush_all = true;
+    else
+        b->invlpg[b->nr_invlpg++] = linear;
+}
+
+void mmu_batch_flush_tlb(struct mmu_batch *b)
+{
+    b->flush_all = true;
+}
+
+int mmu_batch_flush(struct mmu_batch *b)
+{
+    mmuext_op_t op;
+    unsigned int i;
+    int rc;
+
+    if ( b->flush_all )
+    {
+        op = (mmuext_op_t){ .cmd = MMUEXT_TLB_FLUSH_LOCAL };
+        mmu_batch_ext(b, &op);
+    }
+    else
+    {
+        for ( i = 0; i < b->nr_invlpg; ++i )
+        {
+            op = (mmuext_op_t){
+                .cmd = MMUEXT_INVLPG_LOCAL,
+                .arg1.linear_addr = b->invlpg[i],
+            };
+            mmu_batch_ext(b, &op);
+        }
+    }
+
+    b->flush_all = false;
+    b->nr_invlpg = 0;
+
+    submit(b);
+
+    rc = b->rc;
+    b->rc = 0;
+
+    return rc;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,46 @@
+/**
+ * @file arch/x86/pv/pagetable.c
+ *
+ * Access to PV pagetables.
+ */
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+
+#include <arch/mm.h>
+#include <arch/pagetable.h>
+#include <arch/traps.h>
+
+intpte_t *pv_l1e(unsigned long linear)
+{
+    intpte_t *t = _p(pv_start_info->pt_base);
+    unsigned int level;
+
+    for ( level = CONFIG_PAGING_LEVELS; level > 1; --level )
+    {
+        unsigned int shift = PAGE_SHIFT + (level - 1) * PT_ORDER;
+        intpte_t pte = t[(linear >> shift) & (L1_PT_ENTRIES - 1)];
+
+        if ( (pte & (_PAGE_PRESENT | _PAGE_PSE)) != _PAGE_PRESENT )
+            return NULL;
+
+        t = maddr_to_virt(pte_to_paddr(pte));
+    }
+
+    return &t[l1_table_offset(linear)];
+}
+
+int pv_writable_pagetables(void)
+{
+    return hypercall_vm_assist(VMASST_CMD_enable,
+                               VMASST_TYPE_writable_pagetables);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
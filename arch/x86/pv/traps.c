@@ -5,6 +5,7 @@
 
 #include <arch/idt.h>
 #include <arch/lib.h>
+#include <arch/mmu-batch.h>
 #include <arch/processor.h>
 #include <arch/segment.h>
 #include <arch/pagetable.h>
@@ -84,18 +85,33 @@ static int remap_linear(const void *linear, uint64_t flags)
     return hypercall_update_va_mapping(_u(linear), nl1e, UVMF_INVLPG);
 }
 
+/*
+ * Remap a range with mmu_update requests against the L1 entries directly,
+ * rather than update_va_mapping, so consecutive PTEs share one hypercall.
+ */
 static int __maybe_unused remap_linear_range(const void *start, const void *end,
                                              uint64_t flags)
 {
-    int ret = 0;
+    static struct mmu_batch batch;
+
+    mmu_batch_init(&batch);
 
-    while ( !ret && start < end )
+    for ( ; start < end; start += PAGE_SIZE )
     {
-        ret = remap_linear(start, flags);
-        start += PAGE_SIZE;
+        intpte_t *l1e = pv_l1e(_u(start));
+
+        if ( !l1e )
+        {
+            mmu_batch_flush(&batch);
+            return -EFAULT;
+        }
+
+        mmu_batch_update(&batch, virt_to_maddr(l1e),
+                         pte_from_virt(start, flags));
+        mmu_batch_invlpg(&batch, _u(start));
     }
 
-    return ret;
+    return mmu_batch_flush(&batch);
 }
 
 static void init_callbacks(void)
@@ -206,6 +222,15 @@ void arch_init_traps(void)
         panic("Failed to unmap page at NULL: %d\n", rc);
 }
 
+void arch_init_ap_traps(unsigned int cpu, uint8_t *stack)
+{
+    /*
+     * The trap table, GDT, kernel stack and pagetables are all set up by
+     * VCPUOP_initialise, but the callbacks are only partially covered.
+     */
+    init_callbacks();
+}
+
 void __noreturn arch_crash_hard(void)
 {
     /*
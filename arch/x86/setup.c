@@ -2,6 +2,7 @@
 #include <xtf/hypercall.h>
 #include <xtf/extable.h>
 #include <xtf/report.h>
+#include <xtf/traps.h>
 #include <xtf/xenbus.h>
 
 #include <arch/cpuid.h>
@@ -30,6 +31,8 @@ unsigned int maxphysaddr, maxvirtaddr;
 const char environment_description[] = ENVIRONMENT_DESCRIPTION;
 
 shared_info_t shared_info __page_aligned_bss;
+struct vcpu_runstate_info runstate[NR_CPUS];
+bool runstate_registered[NR_CPUS];
 
 static void collect_cpuid(cpuid_count_fn_t cpuid_fn)
 {
@@ -102,7 +105,7 @@ static void collect_cpuid(cpuid_count_fn_t cpuid_fn)
  * Find the Xen CPUID leaves.  They may be at 0x4000_0000, or at 0x4000_0100
  * if Xen is e.g. providing a viridian interface to the guest too.
  */
-static unsigned int find_xen_leaves(void)
+unsigned int find_xen_leaves(void)
 {
     static unsigned int leaves;
 
@@ -243,6 +246,22 @@ static void map_shared_info(void)
         panic("Failed to map shared_info: %d\n", rc);
 }
 
+void register_runstate_area(unsigned int cpu)
+{
+    struct vcpu_register_runstate_memory_area area = {
+        .addr.v = &runstate[cpu],
+    };
+    int rc = hypercall_vcpu_op(VCPUOP_register_runstate_memory_area,
+                               cpu, &area);
+
+    /* Not fatal, but steal time can't be accounted for on this vCPU. */
+    if ( rc )
+        printk("Failed to register runstate area for vCPU %u: %d\n",
+               cpu, rc);
+    else
+        runstate_registered[cpu] = true;
+}
+
 static void qemu_console_write(const char *buf, size_t len)
 {
     rep_outsb(buf, len, 0x12);
@@ -261,6 +280,7 @@ void arch_setup(void)
     register_console_callback(xen_console_write);
 
     collect_cpuid(IS_DEFINED(CONFIG_PV) ? pv_cpuid_count : cpuid_count);
+    libc_init_string(cpu_has_erms, cpu_has_fsrm);
 
     sort_extable();
 
@@ -275,6 +295,7 @@ void arch_setup(void)
     }
 
     map_shared_info();
+    register_runstate_area(0);
 }
 
 int arch_get_domid(void)
@@ -0,0 +1,247 @@
+/**
+ * @file arch/x86/smp.c
+ *
+ * Bring-up of secondary vCPUs.
+ */
+#include <xtf/atomic.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/smp.h>
+
+#include <arch/cpuid.h>
+#include <arch/desc.h>
+#include <arch/mm.h>
+#include <arch/msr.h>
+#include <arch/processor.h>
+#include <arch/traps.h>
+
+/*
+ * AP stacks, laid out like boot_stack[].  The base of each page holds the
+ * vCPU ID, for smp_processor_id().  Slot 0 (the BSP) is unused.
+ */
+static uint8_t ap_stack[NR_CPUS][3 * PAGE_SIZE] __page_aligned_bss;
+
+static void (*ap_fn[NR_CPUS])(unsigned int cpu);
+static bool ap_initialised[NR_CPUS];
+
+/* AP entry point, in head.S */
+void _ap_start(void);
+void __noreturn ap_main(unsigned int cpu);
+
+#if defined(CONFIG_PV)
+/* Real entry points, in entry_*.S */
+void entry_EVTCHN(void);
+void entry_SYSCALL(void);
+
+extern struct xen_trap_info pv_default_trap_info[];
+#endif
+
+unsigned int smp_processor_id(void)
+{
+    unsigned long sp;
+
+    asm ("mov %%" _ASM_SP ", %0" : "=r" (sp));
+
+    return *(const unsigned int *)(sp & PAGE_MASK);
+}
+
+unsigned int smp_nr_cpus(void)
+{
+    unsigned int cpu;
+
+    /* Non-existent vCPUs fail with -ENOENT. */
+    for ( cpu = 1; cpu < NR_CPUS; ++cpu )
+        if ( hypercall_vcpu_op(VCPUOP_is_up, cpu, NULL) < 0 )
+            break;
+
+    return cpu;
+}
+
+void __noreturn ap_main(unsigned int cpu)
+{
+    arch_init_ap_traps(cpu, ap_stack[cpu]);
+    register_runstate_area(cpu);
+
+    for ( ;; )
+    {
+        ACCESS_ONCE(ap_fn[cpu])(cpu);
+
+        /*
+         * Synchronous when issued on ourselves.  A subsequent VCPUOP_up
+         * resumes execution here.
+         */
+        hypercall_vcpu_op(VCPUOP_down, cpu, NULL);
+    }
+}
+
+#if defined(CONFIG_HVM)
+static int init_ap(unsigned int cpu)
+{
+    uint8_t *stack = ap_stack[cpu];
+    struct xen_vcpu_hvm_context ctx = {
+#ifdef __x86_64__
+        .mode = VCPU_HVM_MODE_64B,
+        .cpu_regs.x86_64 = {
+            .rip    = _u(_ap_start),
+            .rsp    = _u(&stack[PAGE_SIZE]),
+            .rdi    = cpu,
+            .rflags = X86_EFLAGS_MBS,
+
+            /* Same as BSP */
+            .cr0    = read_cr0(),
+            .cr3    = read_cr3(),
+            .cr4    = read_cr4(),
+            .efer   = rdmsr(MSR_EFER),
+        },
+#else
+        /* 32bit Flat Mode */
+        .mode = VCPU_HVM_MODE_32B,
+        .cpu_regs.x86_32 = {
+            .eip    = _u(_ap_start),
+            .esp    = _u(&stack[PAGE_SIZE]),
+            .eax    = cpu,
+            .eflags = X86_EFLAGS_MBS,
+
+            /* Same as BSP */
+            .cr0    = read_cr0(),
+            .cr3    = read_cr3(),
+            .cr4    = read_cr4(),
+            .efer   = cpu_has_nx ? rdmsr(MSR_EFER) & EFER_NXE : 0,
+
+            .cs_limit = ~0U,
+            .ds_limit = ~0U,
+            .ss_limit = ~0U,
+            .es_limit = ~0U,
+            .tr_limit = 0x67,
+
+            .cs_ar = 0xc9b,
+            .ds_ar = 0xc93,
+            .ss_ar = 0xc93,
+            .es_ar = 0xc93,
+            .tr_ar = 0x08b,
+        },
+#endif
+    };
+
+    return hypercall_vcpu_op(VCPUOP_initialise, cpu, &ctx);
+}
+#else /* CONFIG_PV */
+static int init_ap(unsigned int cpu)
+{
+    /* Too large for the stack. */
+    static struct xen_vcpu_guest_context ctx;
+    const struct xen_trap_info *ti;
+    uint8_t *stack = ap_stack[cpu];
+
+    memset(&ctx, 0, sizeof(ctx));
+
+    ctx.flags = VGCF_in_kernel;
+
+    ctx.user_regs.cs = __KERN_CS;
+    ctx.user_regs.ss = __KERN_DS;
+    ctx.user_regs.ds = __USER_DS;
+    ctx.user_regs.es = __USER_DS;
+    ctx.user_regs.fs = __USER_DS;
+    ctx.user_regs.gs = __USER_DS;
+#ifdef __x86_64__
+    ctx.user_regs.rip = _u(_ap_start);
+    ctx.user_regs.rsp = _u(&stack[PAGE_SIZE]);
+    ctx.user_regs.rdi = cpu;
+    ctx.user_regs.rflags = X86_EFLAGS_MBS;
+#else
+    ctx.user_regs.eip = _u(_ap_start);
+    ctx.user_regs.esp = _u(&stack[PAGE_SIZE]);
+    ctx.user_regs.eax = cpu;
+    ctx.user_regs.eflags = X86_EFLAGS_MBS;
+#endif
+
+    for ( ti = pv_default_trap_info; ti->address; ++ti )
+        ctx.trap_ctxt[ti->vector] = *ti;
+
+    /* Same GDT as BSP.  Already mapped read-only. */
+    ctx.gdt_frames[0] = virt_to_mfn(gdt);
+    ctx.gdt_ents = NR_GDT_ENTRIES;
+
+    ctx.kernel_ss = __KERN_DS;
+    ctx.kernel_sp = _u(&stack[2 * PAGE_SIZE]);
+
+    /* Same pagetables as BSP, in Xen's %cr3 format. */
+    ctx.ctrlreg[3] = read_cr3();
+
+#ifdef __x86_64__
+    /* XTF uses a shared user/kernel address space. */
+    ctx.ctrlreg[1] = read_cr3();
+
+    ctx.flags |= VGCF_syscall_disables_events;
+    ctx.event_callback_eip = _u(entry_EVTCHN);
+    ctx.syscall_callback_eip = _u(entry_SYSCALL);
+#else
+    ctx.event_callback_cs = __KERN_CS;
+    ctx.event_callback_eip = _u(entry_EVTCHN);
+#endif
+
+    return hypercall_vcpu_op(VCPUOP_initialise, cpu, &ctx);
+}
+#endif /* CONFIG_HVM */
+
+void smp_wait_cpu(unsigned int cpu)
+{
+    while ( hypercall_vcpu_op(VCPUOP_is_up, cpu, NULL) > 0 )
+        cpu_relax();
+}
+
+int smp_start_cpu(unsigned int cpu, void (*fn)(unsigned int cpu))
+{
+    unsigned int i;
+    int rc;
+
+    if ( cpu == 0 || cpu >= NR_CPUS )
+        return -EINVAL;
+
+    /* Wait for the previous callback to complete. */
+    if ( ap_initialised[cpu] )
+        smp_wait_cpu(cpu);
+
+    ap_fn[cpu] = fn;
+    smp_wmb();
+
+    if ( !ap_initialised[cpu] )
+    {
+        for ( i = 0; i < 3; ++i )
+            *(unsigned int *)&ap_stack[cpu][i * PAGE_SIZE] = cpu;
+
+        rc = init_ap(cpu);
+        if ( rc )
+            return rc;
+
+        ap_initialised[cpu] = true;
+        printk_prefix = true;
+    }
+
+    return hypercall_vcpu_op(VCPUOP_up, cpu, NULL);
+}
+
+int smp_start_cpus(unsigned int nr, void (*fn)(unsigned int cpu))
+{
+    unsigned int cpu;
+    int rc;
+
+    for ( cpu = 1; cpu < nr; ++cpu )
+    {
+        rc = smp_start_cpu(cpu, fn);
+        if ( rc )
+            return rc;
+    }
+
+    return 0;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -4,6 +4,8 @@
 # obj-perenv   get get compiled once for each environment
 # obj-$(env)   are objects unique to a specific environment
 
+obj-perbits += $(ROOT)/common/arena.o
+obj-perbits += $(ROOT)/common/bench.o
 obj-perbits += $(ROOT)/common/console.o
 obj-perbits += $(ROOT)/common/extable.o
 obj-perbits += $(ROOT)/common/grant_table.o
@@ -12,8 +14,12 @@ obj-perbits += $(ROOT)/common/lib.o
 obj-perbits += $(ROOT)/common/libc/stdio.o
 obj-perbits += $(ROOT)/common/libc/string.o
 obj-perbits += $(ROOT)/common/libc/vsnprintf.o
+obj-perbits += $(ROOT)/common/numa.o
+obj-perbits += $(ROOT)/common/page_alloc.o
 obj-perbits += $(ROOT)/common/report.o
 obj-perbits += $(ROOT)/common/setup.o
+obj-perbits += $(ROOT)/common/spinlock.o
+obj-perbits += $(ROOT)/common/time.o
 obj-perbits += $(ROOT)/common/xenbus.o
 obj-perbits += $(ROOT)/common/weak-defaults.o
 
@@ -23,7 +29,9 @@ obj-perenv += $(ROOT)/arch/x86/extable.o
 obj-perenv += $(ROOT)/arch/x86/grant_table.o
 obj-perenv += $(ROOT)/arch/x86/hypercall_page.o
 obj-perenv += $(ROOT)/arch/x86/msr.o
+obj-perenv += $(ROOT)/arch/x86/page_alloc.o
 obj-perenv += $(ROOT)/arch/x86/setup.o
+obj-perenv += $(ROOT)/arch/x86/smp.o
 obj-perenv += $(ROOT)/arch/x86/traps.o
 
 
@@ -31,6 +39,7 @@ obj-perenv += $(ROOT)/arch/x86/traps.o
 obj-hvm += $(ROOT)/arch/x86/apic.o
 obj-hvm += $(ROOT)/arch/x86/hpet.o
 obj-hvm += $(ROOT)/arch/x86/hvm/head.o
+obj-hvm += $(ROOT)/arch/x86/hvm/pagetable.o
 obj-hvm += $(ROOT)/arch/x86/hvm/pagetables.o
 obj-hvm += $(ROOT)/arch/x86/hvm/traps.o
 obj-hvm += $(ROOT)/arch/x86/io-apic.o
@@ -44,6 +53,8 @@ $(foreach env,$(HVM_ENVIRONMENTS),$(eval obj-$(env) += $(obj-hvm)))
 
 # PV specific objects
 obj-pv  += $(ROOT)/arch/x86/pv/head.o
+obj-pv  += $(ROOT)/arch/x86/pv/mmu-batch.o
+obj-pv  += $(ROOT)/arch/x86/pv/pagetable.o
 obj-pv  += $(ROOT)/arch/x86/pv/traps.o
 $(foreach env,$(PV_ENVIRONMENTS),$(eval obj-$(env) += $(obj-pv)))
 
@@ -3,8 +3,12 @@
 """
 Construct an xl configuration file for a test (from various fragments), and
 substitue variables appropriately.
+
+@@VNUMA<N>@@ expands to a vnuma list splitting the memory and vCPUs evenly
+over N virtual nodes, on physical nodes 0 to N-1.
 """
 import os
+import re
 import sys
 
 # Usage: mkcfg.py $OUT $DEFAULT-CFG $EXTRA-CFG $VARY-CFG
@@ -19,8 +23,37 @@
     parts = name.split('~', 1)
     name, variation = parts[0], '~' + parts[1]
 
+def vnuma(nodes, config):
+    """
+    Construct an xl vnuma list splitting the domain's memory and vCPUs evenly
+    over $nodes virtual nodes, placed on physical nodes 0 to $nodes - 1.
+    """
+    mem = re.findall(r"^\s*memory\s*=\s*(\d+)", config, re.M)
+    if not mem:
+        raise ValueError("%s: vNUMA requires memory to be set" % (out, ))
+    mem, nr_vcpus = int(mem[-1]), int(vcpus)
+
+    if nodes < 1 or nr_vcpus < nodes:
+        raise ValueError("%s: Can't split %d vCPUs over %d vNUMA nodes" %
+                         (out, nr_vcpus, nodes))
+
+    vnodes = []
+    for n in range(nodes):
+        size = mem // nodes + (mem % nodes if n == nodes - 1 else 0)
+        first = n * nr_vcpus // nodes
+        last = (n + 1) * nr_vcpus // nodes - 1
+        dist = ",".join("10" if d == n else "20" for d in range(nodes))
+
+        vnodes.append('["pnode=%d", "size=%d", "vcpus=%d-%d", "vdistances=%s"]'
+                      % (n, size, first, last, dist))
+
+    return "[ " + ", ".join(vnodes) + " ]"
+
 def expand(text):
     """ Expand certain variables in text """
+    text = re.sub(r"@@VNUMA(\d+)@@",
+                  lambda m: vnuma(int(m.group(1)), text), text)
+
     return (text
             .replace("@@NAME@@",   name)
             .replace("@@ENV@@",    env)
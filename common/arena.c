@@ -0,0 +1,126 @@
+/**
+ * @file common/arena.c
+ *
+ * Arena (bump) allocator for transient test data.
+ */
+#include <xtf/arena.h>
+#include <xtf/lib.h>
+#include <xtf/libc.h>
+#include <xtf/page_alloc.h>
+
+/* Header at the start of each chunk. */
+struct arena_chunk
+{
+    struct arena_chunk *prev;
+    unsigned int order;
+};
+
+static char *chunk_end(const struct arena *a, const struct arena_chunk *c)
+{
+    return (char *)c + (PAGE_SIZE << c->order) -
+        ((a->flags & ARENA_GUARD) ? PAGE_SIZE : 0);
+}
+
+static void free_chunk(const struct arena *a, struct arena_chunk *c)
+{
+    if ( a->flags & ARENA_GUARD )
+    {
+        int rc = page_set_guard(chunk_end(a, c), false);
+
+        if ( rc )
+            panic("arena: Failed to remap guard at %p: %d\n",
+                  chunk_end(a, c), rc);
+    }
+
+    free_pages(c, c->order);
+}
+
+/* Take a new chunk, large enough for @size bytes at @align. */
+static bool new_chunk(struct arena *a, size_t size, size_t align)
+{
+    size_t need = ROUNDUP(sizeof(struct arena_chunk), align) + size +
+        ((a->flags & ARENA_GUARD) ? PAGE_SIZE : 0);
+    unsigned int order = a->order;
+    struct arena_chunk *c;
+
+    while ( (size_t)(PAGE_SIZE << order) < need )
+        if ( ++order > PAGE_ALLOC_MAX_ORDER )
+            return false;
+
+    if ( !(c = alloc_pages(order)) )
+        return false;
+
+    c->prev = a->chunk;
+    c->order = order;
+
+    if ( (a->flags & ARENA_GUARD) && page_set_guard(chunk_end(a, c), true) )
+    {
+        free_pages(c, order);
+        return false;
+    }
+
+    a->chunk = c;
+    a->ptr = (char *)(c + 1);
+    a->end = chunk_end(a, c);
+
+    return true;
+}
+
+void *arena_alloc_aligned(struct arena *a, size_t size, size_t align)
+{
+    char *p;
+
+    if ( align & (align - 1) || align > PAGE_SIZE )
+        panic("arena: Bad alignment %#zx\n", align);
+
+    p = _p(ROUNDUP(_u(a->ptr), align));
+
+    if ( !a->chunk || p > a->end || size > (size_t)(a->end - p) )
+    {
+        if ( !new_chunk(a, size, align) )
+            return NULL;
+
+        p = _p(ROUNDUP(_u(a->ptr), align));
+    }
+
+    a->ptr = p + size;
+
+    return p;
+}
+
+void *arena_zalloc(struct arena *a, size_t size)
+{
+    void *p = arena_alloc(a, size);
+
+    if ( p )
+        memset(p, 0, size);
+
+    return p;
+}
+
+void arena_reset(struct arena *a, struct arena_mark m)
+{
+    while ( a->chunk != m.chunk )
+    {
+        struct arena_chunk *c = a->chunk;
+
+        if ( !c )
+            panic("arena: Reset to a mark not in this arena\n");
+
+        a->chunk = c->prev;
+        free_chunk(a, c);
+    }
+
+    a->ptr = m.ptr;
+    a->end = m.chunk ? chunk_end(a, m.chunk) : NULL;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
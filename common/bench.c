@@ -0,0 +1,205 @@
+/**
+ * @file common/bench.c
+ *
+ * Helpers for summarising and reporting microbenchmark samples.
+ */
+#include <xtf/bench.h>
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/traps.h>
+
+#include <arch/cpuid.h>
+#include <arch/div.h>
+
+static int compare_u64(const void *_l, const void *_r)
+{
+    const uint64_t *l = _l, *r = _r;
+
+    return (*l > *r) - (*l < *r);
+}
+
+static void swap_u64(void *_l, void *_r)
+{
+    uint64_t tmp, *l = _l, *r = _r;
+
+    tmp = *l;
+    *l = *r;
+    *r = tmp;
+}
+
+static uint64_t scale(uint64_t val, unsigned int div)
+{
+    divmod64(&val, div);
+
+    return val;
+}
+
+uint32_t bench_tsc_khz(void)
+{
+    static uint32_t tsc_khz;
+    uint32_t tmp;
+
+    if ( !tsc_khz )
+        cpuid_count(find_xen_leaves() + 3, 0, &tmp, &tmp, &tsc_khz, &tmp);
+
+    return tsc_khz;
+}
+
+uint64_t bench_tsc_to_ns(uint64_t tsc)
+{
+    tsc *= 1000000;
+    divmod64(&tsc, bench_tsc_khz() ?: 1);
+
+    return tsc;
+}
+
+/* Whether the calling vCPU has a runstate area, so steal can be measured. */
+static bool have_runstate(unsigned int cpu)
+{
+    /* smp_processor_id() is garbage off the framework's stacks. */
+    return cpu < NR_CPUS && runstate_registered[cpu];
+}
+
+uint64_t bench_stolen_ns(void)
+{
+    unsigned int cpu = smp_processor_id();
+    const struct vcpu_runstate_info *rs;
+
+    if ( !have_runstate(cpu) )
+        return 0;
+
+    rs = &runstate[cpu];
+
+    /* Xen only updates the area while this vCPU isn't running. */
+    return ACCESS_ONCE(rs->time[RUNSTATE_runnable]) +
+        ACCESS_ONCE(rs->time[RUNSTATE_offline]);
+}
+
+void bench_collect(uint64_t samples[], unsigned int nr,
+                   uint64_t (*fn)(void *arg), void *arg,
+                   struct bench_steal *steal)
+{
+    unsigned int i = 0, retries = nr;
+
+    steal->discarded = steal->flagged = 0;
+    steal->unavailable = !have_runstate(smp_processor_id());
+
+    while ( i < nr )
+    {
+        uint64_t stolen = bench_stolen_ns();
+
+        samples[i] = fn(arg);
+
+        if ( bench_stolen_ns() != stolen )
+        {
+            if ( retries )
+            {
+                retries--;
+                steal->discarded++;
+                continue;
+            }
+
+            steal->flagged++;
+        }
+
+        ++i;
+    }
+}
+
+void bench_summarise(struct bench_stats *s, uint64_t samples[],
+                     unsigned int nr, unsigned int batch)
+{
+    uint64_t sum = 0;
+    unsigned int i;
+
+    ASSERT(nr && batch);
+
+    heapsort(samples, nr, sizeof(*samples), compare_u64, swap_u64);
+
+    for ( i = 0; i < nr; ++i )
+        sum += samples[i];
+
+    s->nr     = nr;
+    s->min    = scale(samples[0], batch);
+    s->median = scale(samples[nr / 2], batch);
+    s->mean   = scale(scale(sum, nr), batch);
+    s->max    = scale(samples[nr - 1], batch);
+}
+
+uint64_t bench_per_sec(uint64_t events, uint64_t ns)
+{
+    uint64_t val = events * 1000000000ull;
+
+    /* divmod64() only takes a 32bit divisor. */
+    while ( ns > ~0u )
+    {
+        ns >>= 1;
+        val >>= 1;
+    }
+
+    divmod64(&val, ns ?: 1);
+
+    return val;
+}
+
+void bench_print(const char *name, const struct bench_stats *s)
+{
+    printk("  %-24s min %8"PRIu64", median %8"PRIu64
+           ", mean %8"PRIu64", max %8"PRIu64"\n",
+           name, s->min, s->median, s->mean, s->max);
+}
+
+void bench_print_steal(const struct bench_steal *steal)
+{
+    if ( steal->unavailable )
+        printk("    steal time: not available\n");
+    else if ( steal->discarded || steal->flagged )
+        printk("    steal time: %u samples discarded, %u kept\n",
+               steal->discarded, steal->flagged);
+}
+
+void bench_print_histogram(const uint64_t samples[], unsigned int nr)
+{
+    /* Bucket b holds samples in the range [2^(b-1), 2^b). */
+    unsigned int buckets[65] = {}, lo = ARRAY_SIZE(buckets), hi = 0, i;
+    char bar[41];
+
+    for ( i = 0; i < nr; ++i )
+    {
+        uint64_t val = samples[i];
+        unsigned int b = 0;
+
+        while ( val )
+        {
+            val >>= 1;
+            ++b;
+        }
+
+        buckets[b]++;
+        lo = min(lo, b);
+        hi = max(hi, b);
+    }
+
+    for ( i = lo; i <= hi; ++i )
+    {
+        unsigned int len = (buckets[i] * (sizeof(bar) - 1) + nr - 1) / nr;
+
+        memset(bar, '#', len);
+        bar[len] = '\0';
+
+        printk("    %10"PRIu64" - %10"PRIu64": %8u %s\n",
+               i ? (uint64_t)1 << (i - 1) : 0,
+               (i < 64 ? (uint64_t)1 << i : 0) - 1,
+               buckets[i], bar);
+    }
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
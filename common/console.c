@@ -5,8 +5,12 @@
 #include <xtf/hypercall.h>
 #include <xtf/lib.h>
 #include <xtf/libc.h>
+#include <xtf/smp.h>
+#include <xtf/time.h>
 #include <xtf/traps.h>
 
+#include <arch/div.h>
+
 /*
  * Output functions, registered if/when available.
  * Possibilities:
@@ -116,19 +120,268 @@ void init_pv_console(xencons_interface_t *ring, evtchn_port_t port)
     register_console_callback(pv_console_write);
 }
 
+/*
+ * Per-vCPU printk() buffering.
+ *
+ * APs don't write to the sinks themselves.  Each AP formats its output into
+ * its own ring of line records, without any global lock, and the BSP drains
+ * the rings in timestamp order whenever it prints, or explicitly with
+ * printk_flush().
+ *
+ * The exception is an AP on its way out, in printk_unbuffer(), which drains
+ * its own ring and then writes directly.  Records are claimed with a cmpxchg
+ * on cons, so each is written once even if the BSP is draining the same ring.
+ */
+#define PRINTK_LINE 160
+#define PRINTK_RECS 16
+
+struct printk_rec
+{
+    uint64_t ns;
+    unsigned int len;
+    char text[PRINTK_LINE];
+};
+
+static struct printk_buf
+{
+    struct printk_rec rec[PRINTK_RECS];
+    unsigned int prod;          /* Written by the owning AP. */
+    atomic_t cons;              /* Claimed by the flusher(s). */
+    unsigned int dropped;       /* Lines lost to a full ring. */
+    unsigned int dropped_seen;  /* Drops already reported by the flusher. */
+    struct printk_rec cur;      /* Line under construction.  AP private. */
+    bool line_start;            /* Unbuffered output.  AP private. */
+} printk_bufs[NR_CPUS];
+
+bool printk_prefix;
+static bool printk_unbuffered;
+static bool bsp_line_start = true;
+
+static void write_sinks(const char *buf, size_t len)
+{
+    unsigned int i;
+
+    for ( i = 0; i < nr_cons_cb; ++i )
+        output_fns[i](buf, len);
+}
+
+static void write_prefix(unsigned int cpu, uint64_t ns)
+{
+    char pfx[32];
+    uint32_t rem = divmod64(&ns, 1000000000);
+    int len = snprintf(pfx, sizeof(pfx), "[%u %u.%06u] ",
+                       cpu, (unsigned int)ns, rem / 1000);
+
+    write_sinks(pfx, len);
+}
+
+/* Write @p buf directly, prefixing the start of each line. */
+static void write_lines(unsigned int cpu, const char *buf, size_t len,
+                        bool *line_start)
+{
+    uint64_t ns = xtf_now_ns();
+
+    while ( len )
+    {
+        size_t l = 0;
+
+        while ( l < len && buf[l++] != '\n' )
+            ;
+
+        if ( *line_start )
+            write_prefix(cpu, ns);
+
+        write_sinks(buf, l);
+
+        *line_start = buf[l - 1] == '\n';
+        buf += l;
+        len -= l;
+    }
+}
+
+static void commit_line(struct printk_buf *pb)
+{
+    unsigned int prod = pb->prod;
+
+    if ( prod - (unsigned int)atomic_read(&pb->cons) >= PRINTK_RECS )
+        ACCESS_ONCE(pb->dropped)++;
+    else
+    {
+        pb->rec[prod % PRINTK_RECS] = pb->cur;
+        STORE_RELEASE(&pb->prod, prod + 1);
+    }
+
+    pb->cur.len = 0;
+}
+
+static void buffer_lines(unsigned int cpu, const char *buf, size_t len)
+{
+    struct printk_buf *pb = &printk_bufs[cpu];
+    struct printk_rec *cur = &pb->cur;
+    size_t i;
+
+    for ( i = 0; i < len; ++i )
+    {
+        if ( cur->len == 0 )
+            cur->ns = xtf_now_ns();
+
+        cur->text[cur->len++] = buf[i];
+
+        if ( buf[i] == '\n' || cur->len == sizeof(cur->text) )
+            commit_line(pb);
+    }
+}
+
+/*
+ * Claim and write the oldest record in @p pb, if there is one.  Returns false
+ * if the ring is empty, or another flusher claimed the record first.
+ */
+static bool write_rec(struct printk_buf *pb, unsigned int cpu)
+{
+    unsigned int cons = atomic_read(&pb->cons);
+    struct printk_rec rec;
+
+    if ( cons == LOAD_ACQUIRE(&pb->prod) )
+        return false;
+
+    /* Stable until cons moves past it, so copy it before claiming it. */
+    rec = pb->rec[cons % PRINTK_RECS];
+
+    if ( atomic_cmpxchg(&pb->cons, cons, cons + 1) != (int)cons )
+        return false;
+
+    write_prefix(cpu, rec.ns);
+    write_sinks(rec.text, rec.len);
+
+    return true;
+}
+
+static void report_dropped(unsigned int cpu)
+{
+    struct printk_buf *pb = &printk_bufs[cpu];
+    unsigned int dropped = ACCESS_ONCE(pb->dropped);
+
+    if ( dropped != pb->dropped_seen )
+    {
+        char msg[48];
+        int len = snprintf(msg, sizeof(msg), "[%u] %u lines dropped\r\n",
+                           cpu, dropped - pb->dropped_seen);
+
+        write_sinks(msg, len);
+        pb->dropped_seen = dropped;
+    }
+}
+
+void printk_flush(void)
+{
+    struct printk_buf *pb, *next;
+    unsigned int cpu, next_cpu = 0, cons;
+
+    for ( ;; )
+    {
+        /* Find the oldest buffered line across all APs. */
+        next = NULL;
+        for ( cpu = 1; cpu < NR_CPUS; ++cpu )
+        {
+            pb = &printk_bufs[cpu];
+            cons = atomic_read(&pb->cons);
+
+            if ( cons == LOAD_ACQUIRE(&pb->prod) )
+                continue;
+
+            if ( !next ||
+                 (pb->rec[cons % PRINTK_RECS].ns <
+                  next->rec[atomic_read(&next->cons) % PRINTK_RECS].ns) )
+            {
+                next = pb;
+                next_cpu = cpu;
+            }
+        }
+
+        if ( !next )
+            break;
+
+        write_rec(next, next_cpu);
+    }
+
+    for ( cpu = 1; cpu < NR_CPUS; ++cpu )
+        report_dropped(cpu);
+}
+
+/*
+ * smp_processor_id() is only valid on the framework's stacks.  Treat anything
+ * else (e.g. a test's own stack) as the BSP, rather than indexing printk_bufs[]
+ * with a garbage ID.
+ */
+static unsigned int printk_cpu(void)
+{
+    unsigned int cpu = smp_processor_id();
+
+    return cpu < NR_CPUS ? cpu : 0;
+}
+
+void printk_unbuffer(void)
+{
+    unsigned int cpu = printk_cpu();
+    struct printk_buf *pb = &printk_bufs[cpu];
+
+    ACCESS_ONCE(printk_unbuffered) = true;
+
+    if ( cpu == 0 )
+        return printk_flush();
+
+    /* Only the BSP drains every ring.  Write out just our own output. */
+    while ( write_rec(pb, cpu) )
+        ;
+
+    if ( pb->cur.len )
+    {
+        write_prefix(cpu, pb->cur.ns);
+        write_sinks(pb->cur.text, pb->cur.len);
+        pb->line_start = pb->cur.text[pb->cur.len - 1] == '\n';
+        pb->cur.len = 0;
+    }
+    else
+        pb->line_start = true;
+
+    report_dropped(cpu);
+}
+
 void vprintk(const char *fmt, va_list args)
 {
     static char buf[2048];
-    unsigned int i;
+    unsigned int cpu = printk_cpu();
     int rc;
 
+    if ( cpu != 0 )
+    {
+        char ap_buf[2 * PRINTK_LINE];
+
+        rc = vsnprintf_internal(ap_buf, sizeof(ap_buf), fmt, args, LF_TO_CRLF);
+        if ( rc > (int)sizeof(ap_buf) - 1 )
+            rc = sizeof(ap_buf) - 1; /* Truncated. */
+
+        if ( !ACCESS_ONCE(printk_unbuffered) )
+            buffer_lines(cpu, ap_buf, rc);
+        else if ( ACCESS_ONCE(printk_prefix) )
+            write_lines(cpu, ap_buf, rc, &printk_bufs[cpu].line_start);
+        else
+            write_sinks(ap_buf, rc);
+
+        return;
+    }
+
     rc = vsnprintf_internal(buf, sizeof(buf), fmt, args, LF_TO_CRLF);
 
     if ( rc > (int)sizeof(buf) )
         panic("vprintk() buffer overflow\n");
 
-    for ( i = 0; i < nr_cons_cb; ++i )
-        output_fns[i](buf, rc);
+    printk_flush();
+
+    if ( ACCESS_ONCE(printk_prefix) )
+        write_lines(cpu, buf, rc, &bsp_line_start);
+    else
+        write_sinks(buf, rc);
 }
 
 void printk(const char *fmt, ...)
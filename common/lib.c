@@ -16,6 +16,8 @@ void __noreturn panic(const char *fmt, ...)
 {
     va_list args;
 
+    printk_unbuffer();
+
     printk("******************************\n");
 
     printk("PANIC: ");
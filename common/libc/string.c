@@ -1,4 +1,5 @@
 #include <xtf/libc.h>
+#include <xtf/numbers.h>
 
 size_t (strlen)(const char *str)
 {
@@ -65,20 +66,90 @@ int (strncmp)(const char *_s1, const char *_s2, size_t n)
     return 0;
 }
 
-void *(memset)(void *s, int c, size_t n)
+/*
+ * memcpy()/memset()/memcmp() work a word at a time, with byte-wise head and
+ * tail, or with REP MOVSB/STOSB where the CPU makes them fast.  Behaviour is
+ * identical in 32bit and 64bit builds; only the word size differs.
+ */
+typedef unsigned long __attribute__((__may_alias__, __aligned__(1))) word_t;
+
+#define WORD_SIZE sizeof(unsigned long)
+
+/*
+ * With ERMS, REP MOVSB/STOSB beat a word loop once their startup cost has
+ * been amortised.  FSRM makes REP MOVSB fast for short copies, but medium
+ * sized ones are still better done a word at a time.
+ */
+#define ERMS_THRESHOLD 2048
+#define FSRM_LIMIT     128
+
+/*
+ * Copies shorter than movsb_short, or of at least movsb_long bytes, use REP
+ * MOVSB.  Fills of at least stosb_long bytes use REP STOSB.  The defaults
+ * mean never, until libc_init_string() has looked at CPUID.
+ */
+static size_t movsb_short, movsb_long = ~(size_t)0, stosb_long = ~(size_t)0;
+
+void libc_init_string(bool erms, bool fsrm)
 {
-    char *p = s;
+    movsb_short = fsrm ? FSRM_LIMIT : 0;
+    movsb_long = stosb_long = erms ? ERMS_THRESHOLD : ~(size_t)0;
+}
+
+static void *memset_words(void *s, int c, size_t n)
+{
+    unsigned char *p = s;
+    unsigned long pattern = (unsigned char)c * (~0ul / 0xff);
+
+    if ( n >= WORD_SIZE )
+    {
+        for ( ; _u(p) & (WORD_SIZE - 1); --n )
+            *p++ = c;
+
+        for ( ; n >= WORD_SIZE; n -= WORD_SIZE, p += WORD_SIZE )
+            *(word_t *)p = pattern;
+    }
 
-    while ( n-- )
+    for ( ; n; --n )
         *p++ = c;
 
     return s;
 }
 
-void *(memcpy)(void *_d, const void *_s, size_t n)
+static void *memset_stosb(void *s, int c, size_t n)
 {
-    char *d = _d;
-    const char *s = _s;
+    void *p = s;
+
+    asm volatile ("rep stosb"
+                  : "+D" (p), "+c" (n)
+                  : "a" (c)
+                  : "memory");
+
+    return s;
+}
+
+void *(memset)(void *s, int c, size_t n)
+{
+    if ( n >= stosb_long )
+        return memset_stosb(s, c, n);
+
+    return memset_words(s, c, n);
+}
+
+static void *memcpy_words(void *_d, const void *_s, size_t n)
+{
+    unsigned char *d = _d;
+    const unsigned char *s = _s;
+
+    if ( n >= WORD_SIZE )
+    {
+        /* Align the destination.  Unaligned loads are cheap on x86. */
+        for ( ; _u(d) & (WORD_SIZE - 1); --n )
+            *d++ = *s++;
+
+        for ( ; n >= WORD_SIZE; n -= WORD_SIZE, d += WORD_SIZE, s += WORD_SIZE )
+            *(word_t *)d = *(const word_t *)s;
+    }
 
     for ( ; n; --n )
         *d++ = *s++;
@@ -86,11 +157,36 @@ void *(memcpy)(void *_d, const void *_s, size_t n)
     return _d;
 }
 
+static void *memcpy_movsb(void *d, const void *s, size_t n)
+{
+    void *p = d;
+
+    asm volatile ("rep movsb"
+                  : "+D" (p), "+S" (s), "+c" (n)
+                  :: "memory");
+
+    return d;
+}
+
+void *(memcpy)(void *d, const void *s, size_t n)
+{
+    if ( n < movsb_short || n >= movsb_long )
+        return memcpy_movsb(d, s, n);
+
+    return memcpy_words(d, s, n);
+}
+
+/* REPE CMPSB is slow everywhere, so memcmp() only has a word variant. */
 int (memcmp)(const void *s1, const void *s2, size_t n)
 {
     const unsigned char *u1 = s1, *u2 = s2;
     int res = 0;
 
+    /* Skip equal words, leaving the first difference to the byte loop. */
+    for ( ; n >= WORD_SIZE && *(const word_t *)u1 == *(const word_t *)u2;
+          n -= WORD_SIZE, u1 += WORD_SIZE, u2 += WORD_SIZE )
+        ;
+
     for ( ; !res && n; --n )
         res = *u1++ - *u2++;
 
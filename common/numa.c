@@ -0,0 +1,135 @@
+/**
+ * @file common/numa.c
+ *
+ * Virtual NUMA topology, as reported by `XENMEM_get_vnumainfo`.
+ */
+#include <xtf/hypercall.h>
+#include <xtf/lib.h>
+#include <xtf/numa.h>
+#include <xtf/smp.h>
+
+#include <arch/page.h>
+
+static unsigned int nr_nodes = 1, nr_vcpus, nr_ranges;
+static unsigned int distance[NUMA_MAX_NODES * NUMA_MAX_NODES] = { 10 };
+static unsigned int vcpu_to_node[NR_CPUS];
+static struct xen_vmemrange ranges[NUMA_MAX_RANGES];
+
+/* Static, so the handle unions have no stale upper bits in 32bit builds. */
+static struct xen_vnuma_topology_info topo;
+
+void numa_init(void)
+{
+    unsigned int i;
+    long rc;
+
+    topo.domid = DOMID_SELF;
+    topo.nr_vnodes = NUMA_MAX_NODES;
+    topo.nr_vcpus = NR_CPUS;
+    topo.nr_vmemranges = NUMA_MAX_RANGES;
+    topo.vdistance.h = distance;
+    topo.vcpu_to_vnode.h = vcpu_to_node;
+    topo.vmemrange.h = ranges;
+
+    rc = hypercall_memory_op(XENMEM_get_vnumainfo, &topo);
+    if ( rc == -EOPNOTSUPP )
+        return;
+
+    if ( rc )
+    {
+        printk("vNUMA: Unusable topology (%ld): %u nodes, %u vcpus, "
+               "%u ranges\n", rc, topo.nr_vnodes, topo.nr_vcpus,
+               topo.nr_vmemranges);
+        goto single_node;
+    }
+
+    for ( i = 0; i < topo.nr_vcpus; ++i )
+        if ( vcpu_to_node[i] >= topo.nr_vnodes )
+        {
+            printk("vNUMA: vcpu %u on bad node %u\n", i, vcpu_to_node[i]);
+            goto single_node;
+        }
+
+    for ( i = 0; i < topo.nr_vmemranges; ++i )
+        if ( ranges[i].nid >= topo.nr_vnodes )
+        {
+            printk("vNUMA: Range %u on bad node %u\n", i, ranges[i].nid);
+            goto single_node;
+        }
+
+    nr_nodes = topo.nr_vnodes;
+    nr_vcpus = topo.nr_vcpus;
+    nr_ranges = topo.nr_vmemranges;
+
+    printk("vNUMA: %u nodes\n", nr_nodes);
+    for ( i = 0; i < nr_ranges; ++i )
+        printk("  Node %u: [%08"PRIx64", %08"PRIx64")\n",
+               ranges[i].nid, ranges[i].start, ranges[i].end);
+
+    return;
+
+ single_node:
+    /* Xen may have written partial information.  Discard all of it. */
+    memset(distance, 0, sizeof(distance));
+    memset(vcpu_to_node, 0, sizeof(vcpu_to_node));
+    distance[0] = 10;
+}
+
+unsigned int numa_nr_nodes(void)
+{
+    return nr_nodes;
+}
+
+unsigned int numa_cpu_to_node(unsigned int cpu)
+{
+    return cpu < nr_vcpus ? vcpu_to_node[cpu] : 0;
+}
+
+unsigned int numa_distance(unsigned int from, unsigned int to)
+{
+    if ( from >= nr_nodes || to >= nr_nodes )
+        return 0;
+
+    return distance[from * nr_nodes + to];
+}
+
+unsigned int numa_pfn_to_node(unsigned long pfn, unsigned long *end)
+{
+    uint64_t paddr = (uint64_t)pfn << PAGE_SHIFT, next = ~0ull;
+    unsigned int i;
+
+    if ( !nr_ranges )
+    {
+        if ( end )
+            *end = ~0ul;
+        return 0;
+    }
+
+    for ( i = 0; i < nr_ranges; ++i )
+    {
+        if ( paddr >= ranges[i].start && paddr < ranges[i].end )
+        {
+            if ( end )
+                *end = ranges[i].end >> PAGE_SHIFT;
+            return ranges[i].nid;
+        }
+
+        if ( ranges[i].start > paddr )
+            next = min(next, ranges[i].start);
+    }
+
+    if ( end )
+        *end = next >> PAGE_SHIFT;
+
+    return NUMA_NO_NODE;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,263 @@
+/**
+ * @file common/page_alloc.c
+ *
+ * Buddy allocator for guest memory not used by the test image.
+ *
+ * Free blocks are kept on per-node, per-order lists, linked through a header
+ * in the block's first page.  Ranges are split at vNUMA node boundaries, so
+ * every block, and its buddies, are on a single node.  Each range of memory
+ * has a bitmap, carved out of the start of the range, with a bit set for each
+ * page heading a free block, so a buddy can be checked for being free without
+ * trusting the contents of allocated memory.
+ */
+#include <xtf/bitops.h>
+#include <xtf/lib.h>
+#include <xtf/numa.h>
+#include <xtf/page_alloc.h>
+#include <xtf/spinlock.h>
+
+#include <arch/mm.h>
+
+struct free_block
+{
+    struct free_block *next, *prev;
+    unsigned int order;
+};
+
+static struct range
+{
+    unsigned long start, end;   /* Frames, excluding the bitmap. */
+    unsigned long *free_map;    /* Indexed by frame - start. */
+    unsigned int node;
+} ranges[16];
+static unsigned int nr_ranges;
+
+static struct free_block *free_list[NUMA_MAX_NODES][PAGE_ALLOC_MAX_ORDER + 1];
+static unsigned long nr_free[NUMA_MAX_NODES];
+
+static struct ticket_lock lock = TICKET_LOCK_INIT;
+static bool initialised;
+
+static struct range *find_range(unsigned long pfn)
+{
+    for ( unsigned int i = 0; i < nr_ranges; ++i )
+        if ( pfn >= ranges[i].start && pfn < ranges[i].end )
+            return &ranges[i];
+
+    return NULL;
+}
+
+static void list_add(const struct range *r, struct free_block *b,
+                     unsigned int order)
+{
+    b->order = order;
+    b->prev = NULL;
+    b->next = free_list[r->node][order];
+    if ( b->next )
+        b->next->prev = b;
+    free_list[r->node][order] = b;
+}
+
+static void list_del(const struct range *r, struct free_block *b)
+{
+    if ( b->prev )
+        b->prev->next = b->next;
+    else
+        free_list[r->node][b->order] = b->next;
+
+    if ( b->next )
+        b->next->prev = b->prev;
+}
+
+static void free_block(struct range *r, unsigned long pfn, unsigned int order)
+{
+    /* Merge with free buddies, as far as possible. */
+    while ( order < PAGE_ALLOC_MAX_ORDER )
+    {
+        unsigned long buddy = pfn ^ (1ul << order);
+        struct free_block *b = pfn_to_virt(buddy);
+
+        if ( buddy < r->start || buddy >= r->end ||
+             !test_bit(buddy - r->start, r->free_map) || b->order != order )
+            break;
+
+        list_del(r, b);
+        test_and_clear_bit(buddy - r->start, r->free_map);
+
+        pfn &= ~(1ul << order);
+        order++;
+    }
+
+    list_add(r, pfn_to_virt(pfn), order);
+    test_and_set_bit(pfn - r->start, r->free_map);
+}
+
+static void add_node_range(unsigned long start, unsigned long end,
+                           unsigned int node)
+{
+    struct range *r;
+    unsigned long map_pages;
+
+    if ( nr_ranges == ARRAY_SIZE(ranges) )
+    {
+        printk("page_alloc: Ignoring range [%#lx, %#lx)\n", start, end);
+        return;
+    }
+
+    map_pages = ((end - start + CHAR_BIT - 1) / CHAR_BIT + PAGE_SIZE - 1) >>
+        PAGE_SHIFT;
+    if ( end - start <= map_pages )
+        return;
+
+    r = &ranges[nr_ranges++];
+    r->free_map = pfn_to_virt(start);
+    r->start = start + map_pages;
+    r->end = end;
+    r->node = node;
+    memset(r->free_map, 0, map_pages * PAGE_SIZE);
+    nr_free[node] += r->end - r->start;
+
+    /* Free the range in the largest naturally aligned blocks which fit. */
+    for ( unsigned long pfn = r->start; pfn < r->end; )
+    {
+        unsigned int order = PAGE_ALLOC_MAX_ORDER;
+
+        while ( (pfn & ((1ul << order) - 1)) || pfn + (1ul << order) > r->end )
+            order--;
+
+        free_block(r, pfn, order);
+        pfn += 1ul << order;
+    }
+}
+
+void page_alloc_add_range(unsigned long start, unsigned long end)
+{
+    while ( start < end )
+    {
+        unsigned long next;
+        unsigned int node = numa_pfn_to_node(start, &next);
+
+        /* Memory outside of the vNUMA ranges is accounted to node 0. */
+        if ( node == NUMA_NO_NODE )
+            node = 0;
+
+        next = min(next, end);
+        add_node_range(start, next, node);
+        start = next;
+    }
+}
+
+/* Discover memory on first use.  Called with the lock held. */
+static void init_locked(void)
+{
+    if ( !initialised )
+    {
+        initialised = true;
+        arch_page_alloc_init();
+    }
+}
+
+/* Allocate from @node's free lists.  Called with the lock held. */
+static void *alloc_node_locked(unsigned int node, unsigned int order)
+{
+    struct free_block *b = NULL;
+    struct range *r;
+    unsigned long pfn;
+    unsigned int o;
+
+    for ( o = order; o <= PAGE_ALLOC_MAX_ORDER; ++o )
+        if ( (b = free_list[node][o]) )
+            break;
+
+    if ( !b )
+        return NULL;
+
+    pfn = virt_to_pfn(b);
+    r = find_range(pfn);
+
+    list_del(r, b);
+    test_and_clear_bit(pfn - r->start, r->free_map);
+    nr_free[node] -= 1ul << order;
+
+    /* Split, returning the upper halves to the free lists. */
+    while ( o > order )
+    {
+        o--;
+        free_block(r, pfn + (1ul << o), o);
+    }
+
+    return b;
+}
+
+void *alloc_pages_node(unsigned int node, unsigned int order)
+{
+    void *va = NULL;
+
+    if ( order > PAGE_ALLOC_MAX_ORDER ||
+         (node != NUMA_NO_NODE && node >= numa_nr_nodes()) )
+        return NULL;
+
+    ticket_spin_lock(&lock);
+
+    init_locked();
+
+    if ( node != NUMA_NO_NODE )
+        va = alloc_node_locked(node, order);
+    else
+        for ( node = 0; !va && node < numa_nr_nodes(); ++node )
+            va = alloc_node_locked(node, order);
+
+    ticket_spin_unlock(&lock);
+
+    return va;
+}
+
+void free_pages(void *va, unsigned int order)
+{
+    unsigned long pfn = virt_to_pfn(va);
+    struct range *r;
+
+    if ( !va )
+        return;
+
+    ticket_spin_lock(&lock);
+
+    r = find_range(pfn);
+    if ( !r || order > PAGE_ALLOC_MAX_ORDER || (pfn & ((1ul << order) - 1)) ||
+         pfn + (1ul << order) > r->end ||
+         test_bit(pfn - r->start, r->free_map) )
+        panic("free_pages(%p, %u): Bad block\n", va, order);
+
+    free_block(r, pfn, order);
+    nr_free[r->node] += 1ul << order;
+
+    ticket_spin_unlock(&lock);
+}
+
+unsigned long page_alloc_nr_free_node(unsigned int node)
+{
+    unsigned long nr = 0;
+    unsigned int i;
+
+    ticket_spin_lock(&lock);
+
+    init_locked();
+
+    for ( i = 0; i < numa_nr_nodes(); ++i )
+        if ( node == NUMA_NO_NODE || node == i )
+            nr += nr_free[i];
+
+    ticket_spin_unlock(&lock);
+
+    return nr;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
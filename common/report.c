@@ -123,6 +123,7 @@ bool xtf_status_reported(void)
 
 void xtf_exit(void)
 {
+    printk_unbuffer();
     xtf_report_status();
     hypercall_shutdown(SHUTDOWN_poweroff);
     panic("xtf_exit(): hypercall_shutdown(SHUTDOWN_poweroff) returned\n");
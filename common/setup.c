@@ -7,6 +7,7 @@
 #include <xtf/compiler.h>
 #include <xtf/hypercall.h>
 #include <xtf/framework.h>
+#include <xtf/numa.h>
 #include <xtf/test.h>
 #include <xtf/console.h>
 #include <xtf/report.h>
@@ -25,6 +26,8 @@ void __noreturn xtf_main(void)
     printk("Environment: %s\n", environment_description);
     printk("%s\n", test_title);
 
+    numa_init();
+
     test_setup();
 
     if ( !xtf_status_reported() )
@@ -0,0 +1,204 @@
+/**
+ * @file common/spinlock.c
+ *
+ * Ticket and queued (MCS) spinlocks, with an optional paravirtual slow path.
+ */
+#include <xtf/bitops.h>
+#include <xtf/hypercall.h>
+#include <xtf/smp.h>
+#include <xtf/spinlock.h>
+#include <xtf/traps.h>
+
+/* Iterations to spin before blocking, when the slow path is enabled. */
+#define SPIN_THRESHOLD (1u << 10)
+
+bool spinlock_pv;
+
+static unsigned int pv_nr_cpus;
+static evtchn_port_t kick_port[NR_CPUS];
+
+/* Ticket lock slow path: the lock and ticket each blocked vCPU waits for. */
+static struct ticket_waiter
+{
+    const struct ticket_lock *lock;
+    unsigned int want;
+} __aligned(64) ticket_waiting[NR_CPUS];
+
+/* MCS queue nodes.  @next is a vCPU ID plus 1, or 0 for none. */
+static struct mcs_node
+{
+    unsigned int next;
+    bool locked;
+    bool halted;
+} __aligned(64) mcs_nodes[NR_CPUS];
+
+int spinlock_pv_init(unsigned int nr)
+{
+    unsigned int cpu;
+    int rc;
+
+    if ( nr > NR_CPUS )
+        return -EINVAL;
+
+    for ( cpu = 0; cpu < nr; ++cpu )
+    {
+        struct evtchn_bind_ipi bind = { .vcpu = cpu };
+
+        rc = hypercall_evtchn_bind_ipi(&bind);
+        if ( rc )
+            return rc;
+
+        if ( bind.port >= (sizeof(shared_info.evtchn_pending) * CHAR_BIT) )
+            return -ERANGE;
+
+        /* Kicks are only ever polled for.  Don't take upcalls for them. */
+        test_and_set_bit(bind.port, shared_info.evtchn_mask);
+        kick_port[cpu] = bind.port;
+    }
+
+    pv_nr_cpus = nr;
+    spinlock_pv = true;
+
+    return 0;
+}
+
+/*
+ * Block until kicked.  The caller has published that it is waiting, and
+ * rechecked the lock, so a kick sent in the meantime is left pending and the
+ * poll returns immediately.
+ */
+static void pv_wait(unsigned int cpu)
+{
+    hypercall_poll(kick_port[cpu]);
+    test_and_clear_bit(kick_port[cpu], shared_info.evtchn_pending);
+}
+
+void ticket_spin_lock(struct ticket_lock *l)
+{
+    unsigned int i, cpu, me = atomic_fetch_add(&l->next, 1);
+    struct ticket_waiter *w;
+
+    for ( ;; )
+    {
+        for ( i = 0; i < SPIN_THRESHOLD; ++i )
+        {
+            if ( LOAD_ACQUIRE(&l->owner) == me )
+                return;
+            cpu_relax();
+        }
+
+        if ( !spinlock_pv )
+            continue;
+
+        cpu = smp_processor_id();
+        w = &ticket_waiting[cpu];
+
+        w->want = me;
+        ACCESS_ONCE(w->lock) = l;
+        smp_mb();
+
+        if ( ACCESS_ONCE(l->owner) != me )
+            pv_wait(cpu);
+
+        ACCESS_ONCE(w->lock) = NULL;
+    }
+}
+
+void ticket_spin_unlock(struct ticket_lock *l)
+{
+    unsigned int cpu, next = l->owner + 1;
+
+    STORE_RELEASE(&l->owner, next);
+
+    if ( !spinlock_pv )
+        return;
+
+    smp_mb();
+
+    for ( cpu = 0; cpu < pv_nr_cpus; ++cpu )
+    {
+        const struct ticket_waiter *w = &ticket_waiting[cpu];
+
+        if ( ACCESS_ONCE(w->lock) == l && ACCESS_ONCE(w->want) == next )
+        {
+            hypercall_evtchn_send(kick_port[cpu]);
+            break;
+        }
+    }
+}
+
+void mcs_spin_lock(struct mcs_lock *l)
+{
+    unsigned int i, cpu = smp_processor_id();
+    struct mcs_node *node = &mcs_nodes[cpu];
+    int prev;
+
+    node->next = 0;
+    node->locked = false;
+    node->halted = false;
+
+    prev = atomic_xchg(&l->tail, cpu + 1);
+    if ( !prev )
+        return;
+
+    ACCESS_ONCE(mcs_nodes[prev - 1].next) = cpu + 1;
+
+    for ( ;; )
+    {
+        for ( i = 0; i < SPIN_THRESHOLD; ++i )
+        {
+            if ( LOAD_ACQUIRE(&node->locked) )
+                return;
+            cpu_relax();
+        }
+
+        if ( !spinlock_pv )
+            continue;
+
+        ACCESS_ONCE(node->halted) = true;
+        smp_mb();
+
+        if ( !ACCESS_ONCE(node->locked) )
+            pv_wait(cpu);
+
+        ACCESS_ONCE(node->halted) = false;
+    }
+}
+
+void mcs_spin_unlock(struct mcs_lock *l)
+{
+    unsigned int cpu = smp_processor_id(), next;
+    struct mcs_node *node = &mcs_nodes[cpu];
+
+    next = ACCESS_ONCE(node->next);
+    if ( !next )
+    {
+        /* No known successor.  Try to release the lock outright. */
+        if ( atomic_cmpxchg(&l->tail, cpu + 1, 0) == (int)(cpu + 1) )
+            return;
+
+        /* A successor is mid-way through queueing.  Wait for it. */
+        while ( !(next = ACCESS_ONCE(node->next)) )
+            cpu_relax();
+    }
+
+    STORE_RELEASE(&mcs_nodes[next - 1].locked, true);
+
+    if ( !spinlock_pv )
+        return;
+
+    smp_mb();
+
+    if ( ACCESS_ONCE(mcs_nodes[next - 1].halted) )
+        hypercall_evtchn_send(kick_port[next - 1]);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
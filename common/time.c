@@ -0,0 +1,88 @@
+/**
+ * @file common/time.c
+ *
+ * Xen system time, read from the pvclock in shared_info.
+ */
+#include <xtf/atomic.h>
+#include <xtf/smp.h>
+#include <xtf/time.h>
+#include <xtf/traps.h>
+
+#include <arch/lib.h>
+
+/*
+ * Last value returned on any vCPU, to keep time monotonic without a stable
+ * TSC.
+ */
+static atomic64_t last_ns = ATOMIC64_INIT(0);
+
+/*
+ * The calling vCPU's pvclock.  Off the framework's stacks, smp_processor_id()
+ * is meaningless, so fall back to vCPU 0's rather than indexing vcpu_info[]
+ * out of bounds.
+ */
+static const volatile struct vcpu_time_info *this_time(void)
+{
+    unsigned int cpu = smp_processor_id();
+
+    if ( cpu >= ARRAY_SIZE(shared_info.vcpu_info) )
+        cpu = 0;
+
+    return &shared_info.vcpu_info[cpu].time;
+}
+
+bool xtf_tsc_stable(void)
+{
+    return ACCESS_ONCE(this_time()->flags) & XEN_PVCLOCK_TSC_STABLE_BIT;
+}
+
+uint64_t xtf_now_ns(void)
+{
+    const volatile struct vcpu_time_info *t = this_time();
+    uint32_t ver;
+    uint64_t ns, prev, old;
+    uint8_t flags;
+
+    do {
+        ver = t->version;
+        smp_rmb();
+
+        ns = t->system_time +
+            pvclock_scale_delta(rdtsc_ordered() - t->tsc_timestamp,
+                                t->tsc_to_system_mul, t->tsc_shift);
+        flags = t->flags;
+
+        smp_rmb();
+    } while ( (ver & 1) || ver != t->version );
+
+    /* Fast path.  Xen guarantees monotonicity. */
+    if ( flags & XEN_PVCLOCK_TSC_STABLE_BIT )
+        return ns;
+
+    /*
+     * Otherwise, small backwards steps are possible when Xen recalibrates,
+     * and vCPUs' clocks may disagree slightly.  Never return less than any
+     * vCPU has already seen.
+     */
+    prev = atomic64_read(&last_ns);
+    while ( ns > prev )
+    {
+        old = atomic64_cmpxchg(&last_ns, prev, ns);
+        if ( old == prev )
+            return ns;
+
+        prev = old;
+    }
+
+    return prev;
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -156,6 +156,7 @@
 #define X86_FEATURE_CLZERO        (8*32+ 0) /* CLZERO instruction */
 
 /* Intel-defined CPU features, CPUID level 0x00000007:0.edx, word 9 */
+#define X86_FEATURE_FSRM          (9*32+ 4) /* Fast Short REP MOVSB */
 #define X86_FEATURE_RTM_ALWAYS_ABORT (9*32+11) /* RTM disabled (XBEGIN aborts) */
 
 #endif /* XEN_PUBLIC_ARCH_X86_CPUFEATURESET_H */
@@ -3,15 +3,32 @@
 
 #include <xen/xen.h>
 
+#define EVTCHNOP_bind_virq        1
 #define EVTCHNOP_close            3
 #define EVTCHNOP_send             4
 #define EVTCHNOP_status           5
 #define EVTCHNOP_alloc_unbound    6
+#define EVTCHNOP_bind_ipi         7
 #define EVTCHNOP_init_control    11
 #define EVTCHNOP_expand_array    12
 
 typedef uint32_t evtchn_port_t;
 
+struct evtchn_bind_virq {
+    /* IN parameters. */
+    uint32_t virq;
+    uint32_t vcpu;
+    /* OUT parameters. */
+    evtchn_port_t port;
+};
+
+struct evtchn_bind_ipi {
+    /* IN parameters. */
+    uint32_t vcpu;
+    /* OUT parameters. */
+    evtchn_port_t port;
+};
+
 struct evtchn_status {
     /* IN parameters */
     domid_t dom;
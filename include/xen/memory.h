@@ -37,6 +37,23 @@ struct xen_add_to_physmap {
     unsigned long gfn;
 };
 
+#define XENMEM_memory_map           9
+
+/* The guest's pseudo-physical memory map, in e820 format. */
+struct xen_memory_map {
+    unsigned int nr_entries;    /* IN: capacity, OUT: number of entries. */
+    void *buffer;
+};
+
+/* Entries in xen_memory_map.buffer. */
+struct e820entry {
+    uint64_t addr;
+    uint64_t size;
+    uint32_t type;
+} __attribute__((__packed__));
+
+#define E820_RAM 1
+
 #define XENMEM_exchange             11
 
 struct xen_memory_exchange {
@@ -47,6 +64,39 @@ struct xen_memory_exchange {
 
 #define XENMEM_maximum_gpfn         14
 
+#define XENMEM_get_vnumainfo        26
+
+/* A range of guest physical memory, belonging to virtual node @nid. */
+struct xen_vmemrange {
+    uint64_t start, end;
+    unsigned int flags;
+    unsigned int nid;
+};
+
+/*
+ * vNUMA topology.  nr_* are IN: capacity of the arrays, OUT: number of
+ * entries.  -ENOBUFS if any array is too small, with the sizes required.
+ */
+struct xen_vnuma_topology_info {
+    domid_t domid;
+    uint16_t pad;
+    uint32_t nr_vnodes;
+    uint32_t nr_vcpus;
+    uint32_t nr_vmemranges;
+    union {
+        unsigned int *h;        /* nr_vnodes * nr_vnodes distances. */
+        uint64_t pad;
+    } vdistance;
+    union {
+        unsigned int *h;        /* nr_vcpus entries. */
+        uint64_t pad;
+    } vcpu_to_vnode;
+    union {
+        struct xen_vmemrange *h;
+        uint64_t pad;
+    } vmemrange;
+};
+
 #endif /* XEN_PUBLIC_MEMORY_H */
 
 /*
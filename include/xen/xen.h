@@ -69,6 +69,13 @@ typedef uint16_t domid_t;
 #define DOMID_FIRST_RESERVED (0x7ff0U)
 #define DOMID_SELF (0x7ff0U)
 
+/*
+ * Virtual interrupts that a guest OS may receive from Xen.
+ *
+ * 'V.' denotes a per-VCPU VIRQ, which can be bound once per VCPU.
+ */
+#define VIRQ_TIMER      0  /* V. Timebase update, and/or requested timeout.  */
+
 /* Commands to HYPERVISOR_console_io */
 #define CONSOLEIO_write                   0
 
@@ -78,6 +85,13 @@ typedef uint16_t domid_t;
 #define VMASST_CMD_enable                 0
 #define VMASST_CMD_disable                1
 
+/*
+ * x86/PV guests: Support writes to bottom-level PTEs.
+ * Writes to pagetable pages, which are mapped read-only, are trapped and
+ * emulated by Xen, rather than faulting.
+ */
+#define VMASST_TYPE_writable_pagetables  2
+
 /*
  * x86 guests: Sane behaviour for virtual iopl
  *  - virtual iopl updated from do_iret() hypercalls.
@@ -116,6 +130,9 @@ struct vcpu_time_info {
 }; /* 32 bytes */
 typedef struct vcpu_time_info vcpu_time_info_t;
 
+#define XEN_PVCLOCK_TSC_STABLE_BIT     (1 << 0)
+#define XEN_PVCLOCK_GUEST_STOPPED      (1 << 1)
+
 struct vcpu_info {
     /*
      * 'evtchn_upcall_pending' is written non-zero by Xen to indicate
@@ -19,11 +19,19 @@
 #include <xtf/test.h>
 
 /* Optional functionality */
+#include <xtf/arena.h>
 #include <xtf/atomic.h>
+#include <xtf/bench.h>
 #include <xtf/bitops.h>
 #include <xtf/elf.h>
 #include <xtf/grant_table.h>
 #include <xtf/hypercall.h>
+#include <xtf/numa.h>
+#include <xtf/page_alloc.h>
+#include <xtf/smp.h>
+#include <xtf/spinlock.h>
+#include <xtf/spsc.h>
+#include <xtf/time.h>
 #include <xtf/traps.h>
 #include <xtf/xenbus.h>
 #include <xtf/xenstore.h>
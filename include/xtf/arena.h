@@ -0,0 +1,98 @@
+/**
+ * @file include/xtf/arena.h
+ *
+ * Arena (bump) allocator for transient test data, layered on alloc_pages().
+ *
+ * Allocation is a pointer increment within the current chunk, with a new
+ * chunk taken from the page allocator when it runs out.  Nothing is freed
+ * individually.  Instead, arena_mark() records a position, and
+ * arena_reset() frees everything allocated since, so a subtest can tear
+ * down all of its data at once.
+ *
+ * With #ARENA_GUARD, the final page of each chunk is unmapped, so running off
+ * the end of the most recent allocation in a chunk faults, like a NULL
+ * dereference, rather than silently corrupting the next chunk.
+ *
+ * An arena must only be used by one vCPU at a time.
+ */
+#ifndef XTF_ARENA_H
+#define XTF_ARENA_H
+
+#include <xtf/types.h>
+
+#include <arch/page.h>
+
+/** Unmap a guard page at the end of each chunk. */
+#define ARENA_GUARD (1u << 0)
+
+struct arena_chunk;
+
+struct arena
+{
+    struct arena_chunk *chunk;  /**< Current chunk, linked to older ones. */
+    char *ptr, *end;            /**< Free space in the current chunk. */
+    unsigned int order;         /**< Default chunk size, in page order. */
+    unsigned int flags;         /**< ARENA_* */
+};
+
+/** Initialiser for an empty arena, taking chunks of 2^@p o pages. */
+#define ARENA_INIT(o, f) { .order = (o), .flags = (f) }
+
+/** A position in an arena, to reset back to. */
+struct arena_mark
+{
+    struct arena_chunk *chunk;
+    char *ptr;
+};
+
+/**
+ * Allocate @p size bytes, aligned to @p align (a power of two, no larger
+ * than #PAGE_SIZE).  Allocations too large for the default chunk size get
+ * a chunk of their own.
+ *
+ * @returns The allocation, or NULL if out of memory.
+ */
+void *arena_alloc_aligned(struct arena *a, size_t size, size_t align);
+
+/** Allocate @p size bytes, suitably aligned for any type. */
+static inline void *arena_alloc(struct arena *a, size_t size)
+{
+    return arena_alloc_aligned(a, size, 16);
+}
+
+/** Allocate @p size bytes, as arena_alloc(), and zero them. */
+void *arena_zalloc(struct arena *a, size_t size);
+
+/** Allocate an array of @p nr objects of @p type. */
+#define arena_new(a, type, nr)                                          \
+    ((type *)arena_alloc_aligned(a, sizeof(type) * (nr), __alignof__(type)))
+
+/** Record the current position of @p a. */
+static inline struct arena_mark arena_mark(const struct arena *a)
+{
+    return (struct arena_mark){ a->chunk, a->ptr };
+}
+
+/**
+ * Free everything allocated from @p a since @p m was taken.  Chunks taken
+ * since are returned to the page allocator.
+ */
+void arena_reset(struct arena *a, struct arena_mark m);
+
+/** Free everything allocated from @p a. */
+static inline void arena_release(struct arena *a)
+{
+    arena_reset(a, (struct arena_mark){ NULL, NULL });
+}
+
+#endif /* XTF_ARENA_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
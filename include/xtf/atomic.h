@@ -4,6 +4,9 @@
 #include <xtf/lib.h>
 #include <xtf/barrier.h>
 
+#include <arch/atomic.h>
+#include <arch/lib.h>
+
 #define LOAD_ACQUIRE(p)                         \
     ({ typeof(*p) _p = ACCESS_ONCE(*p);         \
         smp_rmb();                              \
@@ -15,6 +18,57 @@
         ACCESS_ONCE(*p) = v;                    \
     })
 
+/**
+ * Single-use spin barrier.  Each of @p nr vCPUs arrives once, and none
+ * leave until all have arrived.  Must be reset with spin_barrier_init()
+ * before reuse, while no vCPUs are waiting.
+ */
+struct spin_barrier
+{
+    atomic_t count;
+};
+
+static inline void spin_barrier_init(struct spin_barrier *b)
+{
+    atomic_set(&b->count, 0);
+}
+
+static inline void spin_barrier_wait(struct spin_barrier *b, unsigned int nr)
+{
+    atomic_inc(&b->count);
+
+    while ( (unsigned int)atomic_read(&b->count) < nr )
+        cpu_relax();
+}
+
+/**
+ * Reusable sense-reversing barrier for @p nr vCPUs.  The last vCPU to arrive
+ * resets the count and flips the sense, releasing the others.
+ */
+struct sense_barrier
+{
+    atomic_t count;
+    unsigned int nr;
+    bool sense;
+};
+
+#define SENSE_BARRIER_INIT(n) { ATOMIC_INIT(0), (n), false }
+
+static inline void sense_barrier_wait(struct sense_barrier *b)
+{
+    /* Stable until every vCPU, including this one, has arrived. */
+    bool sense = !ACCESS_ONCE(b->sense);
+
+    if ( (unsigned int)atomic_fetch_add(&b->count, 1) == b->nr - 1 )
+    {
+        atomic_set(&b->count, 0);
+        STORE_RELEASE(&b->sense, sense);
+    }
+    else
+        while ( ACCESS_ONCE(b->sense) != sense )
+            cpu_relax();
+}
+
 #endif /* XTF_ATOMIC_H */
 
 /*
@@ -0,0 +1,111 @@
+/**
+ * @file include/xtf/bench.h
+ *
+ * Helpers for summarising and reporting microbenchmark samples.
+ *
+ * Samples are unitless 64bit quantities, typically TSC deltas collected with
+ * rdtsc_ordered().  A sample may cover a batch of several identical
+ * operations, to amortise the cost of the timing itself.
+ */
+#ifndef XTF_BENCH_H
+#define XTF_BENCH_H
+
+#include <xtf/types.h>
+
+/** Summary of a set of samples, scaled to a single operation. */
+struct bench_stats
+{
+    unsigned int nr;            /**< Number of samples. */
+    uint64_t min, median, mean, max;
+};
+
+/** Steal time accounting for a set of samples collected by bench_collect(). */
+struct bench_steal
+{
+    unsigned int discarded;     /**< Samples retaken because of steal. */
+    unsigned int flagged;       /**< Samples kept despite steal. */
+    bool unavailable;           /**< No runstate area, so steal unknown. */
+};
+
+/**
+ * TSC frequency in kHz, as reported by Xen in its CPUID leaves.  0 if Xen
+ * doesn't report it, in which case TSC samples can't be converted to time.
+ */
+uint32_t bench_tsc_khz(void);
+
+/** Convert a TSC delta to ns, using bench_tsc_khz(). */
+uint64_t bench_tsc_to_ns(uint64_t tsc);
+
+/**
+ * Time which the calling vCPU has spent runnable or offline, i.e. wanting to
+ * run but descheduled by Xen, in ns.  Read from its registered runstate area,
+ * so always 0 if registration failed.
+ */
+uint64_t bench_stolen_ns(void);
+
+/**
+ * Collect samples on the calling vCPU, excluding those which include steal
+ * time.  If the vCPU has no runstate area, steal is reported as unavailable.
+ *
+ * @p fn is called once per sample, and returns the sample.  A sample during
+ * which the vCPU was descheduled is discarded and retaken, up to @p nr times
+ * in total.  Beyond that, samples including steal time are kept, and flagged
+ * in @p steal.
+ *
+ * @param [out] samples Samples.
+ * @param nr Number of samples to collect.
+ * @param fn Function to take a single sample.
+ * @param arg Argument passed to @p fn.
+ * @param [out] steal Steal time accounting.
+ */
+void bench_collect(uint64_t samples[], unsigned int nr,
+                   uint64_t (*fn)(void *arg), void *arg,
+                   struct bench_steal *steal);
+
+/**
+ * Summarise an array of samples.
+ *
+ * @param [out] s Summary.
+ * @param samples Samples.  Sorted in place.
+ * @param nr Number of samples.  Must be non-zero.
+ * @param batch Number of operations covered by each sample.
+ */
+void bench_summarise(struct bench_stats *s, uint64_t samples[],
+                     unsigned int nr, unsigned int batch);
+
+/**
+ * Convert @p events taking @p ns nanoseconds into a rate per second.
+ *
+ * Precision is reduced, rather than overflowing, for periods longer than
+ * ~4 seconds.
+ */
+uint64_t bench_per_sec(uint64_t events, uint64_t ns);
+
+/**
+ * Print a single line summary, labelled with @p name.
+ */
+void bench_print(const char *name, const struct bench_stats *s);
+
+/**
+ * Print the steal time accounting, if any samples were affected.
+ */
+void bench_print_steal(const struct bench_steal *steal);
+
+/**
+ * Print a histogram of samples, in power-of-two sized buckets.
+ *
+ * Only the range of buckets which contain samples is printed.
+ */
+void bench_print_histogram(const uint64_t samples[], unsigned int nr);
+
+#endif /* XTF_BENCH_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -22,9 +22,32 @@ void register_console_callback(cons_output_cb cb);
 void init_pv_console(xencons_interface_t *ring,
                      evtchn_port_t port);
 
+/*
+ * printk() on an AP is formatted into a per-vCPU buffer, and written to the
+ * consoles the next time the BSP prints, or at printk_flush().  Buffered
+ * lines are written in timestamp order, each prefixed with the vCPU ID and
+ * Xen system time.  Lines are dropped (and counted) if an AP's buffer fills.
+ */
 void vprintk(const char *fmt, va_list args) __printf(1, 0);
 void printk(const char *fmt, ...) __printf(1, 2);
 
+/*
+ * Prefix the BSP's output too.  Set once the first AP is started, so
+ * single-vCPU tests have unprefixed output.
+ */
+extern bool printk_prefix;
+
+/* Write out all buffered AP output.  Only to be called on the BSP. */
+void printk_flush(void);
+
+/*
+ * Stop buffering.  Used on the way out by xtf_exit() and panic(), which may
+ * be running on an AP.  On the BSP, writes out all buffered AP output.  On an
+ * AP, writes out only that AP's own buffered output, leaving the other rings
+ * to the BSP.
+ */
+void printk_unbuffer(void);
+
 size_t pv_console_read_some(char *buf, size_t len);
 
 #endif /* XTF_CONSOLE_H */
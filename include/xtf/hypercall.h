@@ -124,6 +124,19 @@ static inline long hypercall_update_va_mapping(
 #endif
 }
 
+/*
+ * The timeout is an absolute system time in ns, or 0 to cancel the timer.
+ */
+static inline long hypercall_set_timer_op(uint64_t timeout)
+{
+#ifdef __x86_64__
+    return HYPERCALL1(long, __HYPERVISOR_set_timer_op, timeout);
+#else
+    return HYPERCALL2(long, __HYPERVISOR_set_timer_op,
+                      timeout, timeout >> 32);
+#endif
+}
+
 static inline long hypercall_xen_version(unsigned int cmd, void *arg)
 {
     return HYPERCALL2(long, __HYPERVISOR_xen_version, cmd, arg);
@@ -221,6 +234,11 @@ static inline int hypercall_register_callback(const xen_callback_register_t *arg
     return hypercall_callback_op(CALLBACKOP_register, arg);
 }
 
+static inline int hypercall_evtchn_bind_virq(struct evtchn_bind_virq *bind)
+{
+    return hypercall_event_channel_op(EVTCHNOP_bind_virq, bind);
+}
+
 static inline int hypercall_evtchn_close(evtchn_port_t port)
 {
     return hypercall_event_channel_op(EVTCHNOP_close, &port);
@@ -241,6 +259,11 @@ static inline int hypercall_evtchn_alloc_unbound(struct evtchn_alloc_unbound *ub
     return hypercall_event_channel_op(EVTCHNOP_alloc_unbound, ub);
 }
 
+static inline int hypercall_evtchn_bind_ipi(struct evtchn_bind_ipi *bind)
+{
+    return hypercall_event_channel_op(EVTCHNOP_bind_ipi, bind);
+}
+
 static inline int hvm_set_param(unsigned int idx, uint64_t value)
 {
     xen_hvm_param_t p = { .domid = DOMID_SELF, .index = idx, .value = value };
@@ -40,6 +40,12 @@ int memcmp(const void *s1, const void *s2, size_t n);
 
 size_t strnlen(const char *str, size_t max);
 
+/*
+ * Choose the memcpy()/memset() strategies, given the CPU's Enhanced REP
+ * MOVSB/STOSB and Fast Short REP MOV support.  Called once CPUID is known.
+ */
+void libc_init_string(bool erms, bool fsrm);
+
 /*
  * Internal version of vsnprintf(), taking extra control flags.
  *
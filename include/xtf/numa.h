@@ -0,0 +1,61 @@
+/**
+ * @file include/xtf/numa.h
+ *
+ * Virtual NUMA topology, as reported by `XENMEM_get_vnumainfo`.
+ *
+ * The topology is queried once at boot.  If the domain has no vNUMA
+ * configuration (or it is too large to be represented), a single node is
+ * reported, holding all memory and vCPUs, so callers need not special case
+ * non-NUMA guests.
+ *
+ * The page allocator keeps free memory per node; see alloc_pages_node().
+ * vNUMA is configured by the toolstack, e.g. with the `vnuma` variation
+ * (config/vnuma.cfg.in) which splits memory and vCPUs evenly over two nodes.
+ */
+#ifndef XTF_NUMA_H
+#define XTF_NUMA_H
+
+#include <xtf/types.h>
+
+/** Maximum number of virtual nodes supported. */
+#define NUMA_MAX_NODES 8
+
+/** Maximum number of memory ranges supported, over all nodes. */
+#define NUMA_MAX_RANGES 16
+
+/** No particular node. */
+#define NUMA_NO_NODE (~0u)
+
+/** Query the topology.  Called once, at boot. */
+void numa_init(void);
+
+/** Number of nodes.  At least 1. */
+unsigned int numa_nr_nodes(void);
+
+/** Node of vCPU @p cpu. */
+unsigned int numa_cpu_to_node(unsigned int cpu);
+
+/** Distance from node @p from to node @p to.  10 means local. */
+unsigned int numa_distance(unsigned int from, unsigned int to);
+
+/**
+ * Node of frame @p pfn.
+ *
+ * @param pfn Frame to look up.
+ * @param [out] end Optional.  First frame above @p pfn which may be on a
+ *        different node.
+ * @returns The node, or #NUMA_NO_NODE if @p pfn isn't in any memory range.
+ */
+unsigned int numa_pfn_to_node(unsigned long pfn, unsigned long *end);
+
+#endif /* XTF_NUMA_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,95 @@
+/**
+ * @file include/xtf/page_alloc.h
+ *
+ * Buddy allocator for guest memory not used by the test image.
+ *
+ * Free memory is discovered on first use:
+ *  - PV: the padding at the end of the domain builder's initial mapping,
+ *    then the rest of `nr_pages`, mapped 2M at a time with new L1 tables, up
+ *    to the 1G covered by the initial L2 table.
+ *  - HVM: RAM below 4G from the PVH start info memory map, or
+ *    `XENMEM_memory_map` if there isn't one, above the test image.
+ *
+ * Blocks are naturally aligned, from 4K (order 0) to 2M (#PAGE_ORDER_2M),
+ * and are mapped at the virtual address returned.  The allocator is SMP
+ * safe.
+ *
+ * Free memory is tracked per vNUMA node (see xtf/numa.h), so blocks can be
+ * allocated from a specific node with alloc_pages_node().
+ */
+#ifndef XTF_PAGE_ALLOC_H
+#define XTF_PAGE_ALLOC_H
+
+#include <xtf/numa.h>
+#include <xtf/types.h>
+
+#include <arch/page.h>
+
+/** Largest order handed out. */
+#define PAGE_ALLOC_MAX_ORDER PAGE_ORDER_2M
+
+/**
+ * Allocate a naturally aligned block of 2^@p order pages from vNUMA node
+ * @p node, or from the lowest numbered node with space if #NUMA_NO_NODE.
+ *
+ * @returns The block's virtual address, or NULL if none are available.
+ */
+void *alloc_pages_node(unsigned int node, unsigned int order);
+
+/** Allocate a block of 2^@p order pages from any node. */
+static inline void *alloc_pages(unsigned int order)
+{
+    return alloc_pages_node(NUMA_NO_NODE, order);
+}
+
+/** Free a block allocated by alloc_pages() with the same @p order. */
+void free_pages(void *va, unsigned int order);
+
+static inline void *alloc_page(void)
+{
+    return alloc_pages(PAGE_ORDER_4K);
+}
+
+static inline void free_page(void *va)
+{
+    free_pages(va, PAGE_ORDER_4K);
+}
+
+/** Number of free pages on @p node, or on all nodes if #NUMA_NO_NODE. */
+unsigned long page_alloc_nr_free_node(unsigned int node);
+
+/** Number of free pages. */
+static inline unsigned long page_alloc_nr_free(void)
+{
+    return page_alloc_nr_free_node(NUMA_NO_NODE);
+}
+
+/**
+ * Unmap (@p guard true) or remap a single page from alloc_pages(), so stray
+ * accesses to it fault.  Guards must be removed before freeing the page.
+ *
+ * @returns 0 on success, or -errno.  Not supported in unpaged environments.
+ */
+int page_set_guard(void *va, bool guard);
+
+/**
+ * Hand the range of mapped, free frames [@p start, @p end) to the allocator,
+ * split at vNUMA node boundaries.  For arch_page_alloc_init(), which is
+ * called with the allocator's lock held.
+ */
+void page_alloc_add_range(unsigned long start, unsigned long end);
+
+/** Discover free memory, and add it with page_alloc_add_range(). */
+void arch_page_alloc_init(void);
+
+#endif /* XTF_PAGE_ALLOC_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,76 @@
+/**
+ * @file include/xtf/smp.h
+ *
+ * Bring-up of secondary vCPUs (APs).
+ *
+ * vCPU 0 (the BSP) runs the test.  APs are started on request, each on its
+ * own stack, with GDT, TSS and IDT state matching the BSP's at the time they
+ * are started, and run a per-CPU entry callback.  When the callback returns,
+ * the AP takes itself offline, and may be started again later with a
+ * different callback.
+ *
+ * The number of vCPUs is set with `VCPUS` in the test's Makefile.
+ *
+ * Caveats:
+ *  - HVM APs share the BSP's IDT, but have private copies of the GDT.
+ *  - PV APs share the BSP's GDT, but xtf_set_idte() only affects the
+ *    calling vCPU's trap table.
+ *  - printk() on an AP is buffered until the BSP next prints.
+ */
+#ifndef XTF_SMP_H
+#define XTF_SMP_H
+
+#include <xtf/types.h>
+
+/** Maximum number of vCPUs supported (the size of shared_info.vcpu_info[]). */
+#define NR_CPUS 32
+
+/**
+ * Number of vCPUs the domain was created with.  Probed with `VCPUOP_is_up`.
+ */
+unsigned int smp_nr_cpus(void);
+
+/**
+ * The ID of the current vCPU.
+ *
+ * Found at the base of the current stack page, so only valid while running on
+ * one of the framework's stacks.
+ */
+unsigned int smp_processor_id(void);
+
+/**
+ * Start vCPU @p cpu, running @p fn.
+ *
+ * The first time a vCPU is started, it is initialised with `VCPUOP_initialise`.
+ * Afterwards, it is restarted with `VCPUOP_up`, once it has gone offline
+ * following the previous callback.
+ *
+ * @param cpu vCPU to start.  Must be non-zero.
+ * @param fn Entry callback, passed the vCPU ID.
+ * @returns 0 on success, or -errno from Xen.
+ */
+int smp_start_cpu(unsigned int cpu, void (*fn)(unsigned int cpu));
+
+/**
+ * Start vCPUs 1 to @p nr - 1, all running @p fn.
+ *
+ * @returns 0 on success, or -errno from the first failure.
+ */
+int smp_start_cpus(unsigned int nr, void (*fn)(unsigned int cpu));
+
+/**
+ * Wait for @p cpu to return from its entry callback and go offline.
+ */
+void smp_wait_cpu(unsigned int cpu);
+
+#endif /* XTF_SMP_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,65 @@
+/**
+ * @file include/xtf/spinlock.h
+ *
+ * Ticket and queued (MCS) spinlocks, with an optional paravirtual slow path.
+ *
+ * By default, waiters spin with `pause`, leaving Xen's pause-loop exiting (if
+ * any) to deschedule a vCPU waiting on a preempted lock holder.
+ *
+ * After spinlock_pv_init(), waiters which have spun for a while instead block
+ * in `SCHEDOP_poll` on a per-vCPU IPI event channel, and the unlocker kicks
+ * the next waiter with `EVTCHNOP_send`.  The slow path can be toggled with
+ * #spinlock_pv, while no locks are held.
+ *
+ * Each vCPU may hold at most one MCS lock at a time.
+ */
+#ifndef XTF_SPINLOCK_H
+#define XTF_SPINLOCK_H
+
+#include <xtf/atomic.h>
+
+/** FIFO ticket lock.  Waiters spin on the shared @p owner field. */
+struct ticket_lock
+{
+    atomic_t next;              /**< Next ticket to hand out. */
+    unsigned int owner;         /**< Ticket currently holding the lock. */
+};
+
+#define TICKET_LOCK_INIT { ATOMIC_INIT(0), 0 }
+
+/** FIFO queued lock.  Waiters spin on their own per-vCPU node. */
+struct mcs_lock
+{
+    atomic_t tail;              /**< Last vCPU in the queue, plus 1.  0 if free. */
+};
+
+#define MCS_LOCK_INIT { ATOMIC_INIT(0) }
+
+/** Use the paravirtual slow path.  Set by spinlock_pv_init(). */
+extern bool spinlock_pv;
+
+/**
+ * Bind a kick event channel for each of vCPUs 0 to @p nr - 1, and enable the
+ * paravirtual slow path.
+ *
+ * @returns 0 on success, or -errno.
+ */
+int spinlock_pv_init(unsigned int nr);
+
+void ticket_spin_lock(struct ticket_lock *l);
+void ticket_spin_unlock(struct ticket_lock *l);
+
+void mcs_spin_lock(struct mcs_lock *l);
+void mcs_spin_unlock(struct mcs_lock *l);
+
+#endif /* XTF_SPINLOCK_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
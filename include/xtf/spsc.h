@@ -0,0 +1,96 @@
+/**
+ * @file include/xtf/spsc.h
+ *
+ * Lock-free single-producer/single-consumer rings, for passing messages
+ * between a pair of vCPUs.
+ *
+ * `DEFINE_SPSC_RING(name, type, size)` defines `struct name`, a ring of @p
+ * size (a power of two) elements of @p type, and the accessors:
+ *
+ *  - `void name_init(struct name *r)`
+ *  - `bool name_put(struct name *r, const type *v)` (producer only)
+ *  - `bool name_get(struct name *r, type *v)` (consumer only)
+ *
+ * put() and get() fail, rather than wait, when the ring is full or empty.
+ *
+ * As with the console and xenbus rings, the producer and consumer indexes are
+ * free-running, and are only masked when indexing the slots.  Each side keeps
+ * a private copy of the other side's index, on its own cache line, so the
+ * shared indexes are only read when the copy suggests the ring is full or
+ * empty.
+ */
+#ifndef XTF_SPSC_H
+#define XTF_SPSC_H
+
+#include <xtf/atomic.h>
+
+#define DEFINE_SPSC_RING(name, type, size)                              \
+                                                                        \
+struct name                                                             \
+{                                                                       \
+    /* Producer's cache line. */                                        \
+    unsigned int prod;                                                  \
+    unsigned int prod_cons_cache;                                       \
+                                                                        \
+    /* Consumer's cache line. */                                        \
+    unsigned int cons __aligned(64);                                    \
+    unsigned int cons_prod_cache;                                       \
+                                                                        \
+    type slot[size] __aligned(64);                                      \
+};                                                                      \
+                                                                        \
+static inline void name ## _init(struct name *r)                        \
+{                                                                       \
+    BUILD_BUG_ON((size) & ((size) - 1));                                \
+                                                                        \
+    r->prod = r->prod_cons_cache = 0;                                   \
+    r->cons = r->cons_prod_cache = 0;                                   \
+}                                                                       \
+                                                                        \
+static inline bool name ## _put(struct name *r, const type *v)          \
+{                                                                       \
+    unsigned int prod = r->prod;                                        \
+                                                                        \
+    if ( prod - r->prod_cons_cache == (size) )                          \
+    {                                                                   \
+        r->prod_cons_cache = LOAD_ACQUIRE(&r->cons);                    \
+                                                                        \
+        if ( prod - r->prod_cons_cache == (size) )                      \
+            return false;                                               \
+    }                                                                   \
+                                                                        \
+    r->slot[prod & ((size) - 1)] = *v;                                  \
+    STORE_RELEASE(&r->prod, prod + 1);                                  \
+                                                                        \
+    return true;                                                        \
+}                                                                       \
+                                                                        \
+static inline bool name ## _get(struct name *r, type *v)                \
+{                                                                       \
+    unsigned int cons = r->cons;                                        \
+                                                                        \
+    if ( cons == r->cons_prod_cache )                                   \
+    {                                                                   \
+        r->cons_prod_cache = LOAD_ACQUIRE(&r->prod);                    \
+                                                                        \
+        if ( cons == r->cons_prod_cache )                               \
+            return false;                                               \
+    }                                                                   \
+                                                                        \
+    *v = r->slot[cons & ((size) - 1)];                                  \
+    STORE_RELEASE(&r->cons, cons + 1);                                  \
+                                                                        \
+    return true;                                                        \
+}
+
+#endif /* XTF_SPSC_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
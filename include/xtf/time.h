@@ -0,0 +1,51 @@
+/**
+ * @file include/xtf/time.h
+ *
+ * Xen system time, read from the pvclock (`vcpu_time_info`) in shared_info.
+ */
+#ifndef XTF_TIME_H
+#define XTF_TIME_H
+
+#include <xtf/types.h>
+
+/**
+ * Current Xen system time, in nanoseconds since host boot.
+ *
+ * Uses the version/seqlock protocol against the calling vCPU's
+ * `vcpu_time_info`, and scales the TSC delta since Xen's last update.
+ * Doesn't trap in either PV or HVM guests.  Monotonic across all vCPUs, even
+ * if Xen doesn't advertise a stable TSC.
+ */
+uint64_t xtf_now_ns(void);
+
+/**
+ * Whether Xen advertises the TSC as stable (`XEN_PVCLOCK_TSC_STABLE_BIT`),
+ * i.e. that pvclock readings are monotonic without any guest fixup.
+ */
+bool xtf_tsc_stable(void);
+
+/**
+ * Scale a TSC delta into nanoseconds, using the pvclock parameters.
+ */
+static inline uint64_t pvclock_scale_delta(uint64_t delta, uint32_t mul,
+                                           int8_t shift)
+{
+    if ( shift < 0 )
+        delta >>= -shift;
+    else
+        delta <<= shift;
+
+    return (((delta & 0xffffffff) * mul) >> 32) + (delta >> 32) * mul;
+}
+
+#endif /* XTF_TIME_H */
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
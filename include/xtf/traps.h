@@ -2,12 +2,24 @@
 #define XTF_TRAPS_H
 
 #include <xtf/extable.h>
+#include <xtf/smp.h>
 #include <xtf/test.h>
 
 #include <arch/traps.h>
 
+#include <xen/vcpu.h>
+
 extern shared_info_t shared_info;
 
+/**
+ * Per-vCPU runstate, kept up to date by Xen.  vCPU 0's is registered at boot,
+ * and each AP's when it is first started.
+ */
+extern struct vcpu_runstate_info runstate[NR_CPUS];
+
+/** Whether runstate[] has been successfully registered, per vCPU. */
+extern bool runstate_registered[NR_CPUS];
+
 /**
  * May be implemented by a guest to provide custom exception handling.
  */
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+/* Build XTF's string functions under different names to the host's. */
+#define XTF_LIBC_H
+#define strlen  xtf_strlen
+#define strnlen xtf_strnlen
+#define strcpy  xtf_strcpy
+#define strncpy xtf_strncpy
+#define strcmp  xtf_strcmp
+#define strncmp xtf_strncmp
+#define memset  xtf_memset
+#define memcpy  xtf_memcpy
+#define memcmp  xtf_memcmp
+#include "../common/libc/string.c"
+#undef strlen
+#undef strnlen
+#undef strcpy
+#undef strncpy
+#undef strcmp
+#undef strncmp
+#undef memset
+#undef memcpy
+#undef memcmp
+
+/*
+ * To build and run:
+ *
+ * gcc -I include/ -Wall -Werror -Wextra -O3 -mno-sse selftests/string.c -o test-string
+ * ./test-string [--bench]
+ */
+
+#define BUF_SIZE   (64 * 1024)
+#define MAX_OFFSET 16
+#define MAX_LEN    (ERMS_THRESHOLD + 64)
+
+static const struct strategy
+{
+    const char *name;
+    bool erms, fsrm;
+} strategies[] = {
+    { "words", false, false },
+    { "erms",  true,  false },
+    { "fsrm",  true,  true  },
+};
+
+static unsigned char src[BUF_SIZE + MAX_OFFSET];
+static unsigned char dst[BUF_SIZE + 2 * MAX_OFFSET];
+static unsigned char ref[BUF_SIZE + 2 * MAX_OFFSET];
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+static void fill_random(unsigned char *buf, size_t n)
+{
+    uint32_t seed = 0x12345678;
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        buf[i] = seed;
+    }
+}
+
+/* dst is compared against ref in full, to catch writes outside the range. */
+static bool check_memcpy(const char *name, size_t doff, size_t soff, size_t n)
+{
+    memset(dst, 0xa5, sizeof(dst));
+    memset(ref, 0xa5, sizeof(ref));
+
+    memcpy(ref + doff, src + soff, n);
+
+    if ( xtf_memcpy(dst + doff, src + soff, n) != dst + doff ||
+         memcmp(dst, ref, sizeof(dst)) )
+    {
+        printf("  %s: memcpy(dst + %zu, src + %zu, %zu) failed\n",
+               name, doff, soff, n);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_memset(const char *name, size_t doff, int c, size_t n)
+{
+    memset(dst, 0xa5, sizeof(dst));
+    memset(ref, 0xa5, sizeof(ref));
+
+    memset(ref + doff, c, n);
+
+    if ( xtf_memset(dst + doff, c, n) != dst + doff ||
+         memcmp(dst, ref, sizeof(dst)) )
+    {
+        printf("  %s: memset(dst + %zu, %#x, %zu) failed\n",
+               name, doff, c, n);
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_memcmp(size_t off1, size_t off2, size_t n)
+{
+    memcpy(dst + off1, src + off2, n);
+
+    if ( xtf_memcmp(dst + off1, src + off2, n) != 0 )
+    {
+        printf("  memcmp(%zu, %zu, %zu) of equal buffers non-zero\n",
+               off1, off2, n);
+        return false;
+    }
+
+    /* Differ at each position, in each direction. */
+    for ( size_t i = 0; i < n; ++i )
+    {
+        unsigned char orig = dst[off1 + i];
+
+        for ( int delta = -1; delta <= 1; delta += 2 )
+        {
+            dst[off1 + i] = orig + delta;
+
+            if ( sign(xtf_memcmp(dst + off1, src + off2, n)) !=
+                 sign(memcmp(dst + off1, src + off2, n)) )
+            {
+                printf("  memcmp(%zu, %zu, %zu) wrong for difference at %zu\n",
+                       off1, off2, n, i);
+                return false;
+            }
+        }
+
+        dst[off1 + i] = orig;
+    }
+
+    return true;
+}
+
+static bool test_strategy(const struct strategy *s)
+{
+    printf("Testing %s\n", s->name);
+
+    libc_init_string(s->erms, s->fsrm);
+
+    for ( size_t n = 0; n <= MAX_LEN; n += (n < FSRM_LIMIT + 8) ? 1 : 61 )
+        for ( size_t doff = 0; doff < MAX_OFFSET; ++doff )
+        {
+            for ( size_t soff = 0; soff < MAX_OFFSET; ++soff )
+                if ( !check_memcpy(s->name, doff, soff, n) )
+                    return false;
+
+            if ( !check_memset(s->name, doff, 0, n) ||
+                 !check_memset(s->name, doff, 0x5a, n) ||
+                 !check_memset(s->name, doff, 0x1ff, n) )
+                return false;
+        }
+
+    return check_memcpy(s->name, 0, 1, BUF_SIZE) &&
+        check_memset(s->name, 1, 0xc3, BUF_SIZE);
+}
+
+static bool test_memcmp(void)
+{
+    printf("Testing memcmp\n");
+
+    for ( size_t n = 0; n <= 80; ++n )
+        for ( size_t off = 0; off < MAX_OFFSET; off += 3 )
+            if ( !check_memcmp(off, MAX_OFFSET - off - 1, n) )
+                return false;
+
+    return true;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Report throughput in MiB/s, for repeatedly processing n bytes. */
+static void bench(const char *name, size_t n)
+{
+    size_t iters = (256u << 20) / n, i;
+    uint64_t start, ns;
+
+    start = now_ns();
+    for ( i = 0; i < iters; ++i )
+    {
+        if ( !strcmp(name, "memcpy") )
+            xtf_memcpy(dst, src, n);
+        else if ( !strcmp(name, "memset") )
+            xtf_memset(dst, i, n);
+        else
+            xtf_memcmp(dst, src, n);
+
+        asm volatile ("" ::: "memory");
+    }
+    ns = now_ns() - start;
+
+    printf(" %8llu", (unsigned long long)((iters * n * 1000000000ull) /
+                                          ((ns ?: 1) << 20)));
+}
+
+static void run_bench(void)
+{
+    static const size_t sizes[] = { 16, 64, 256, 1024, 4096, BUF_SIZE };
+    static const char *const fns[] = { "memcpy", "memset", "memcmp" };
+
+    printf("Throughput in MiB/s:\n%-14s", "");
+    for ( size_t j = 0; j < sizeof(sizes) / sizeof(*sizes); ++j )
+        printf(" %8zu", sizes[j]);
+    printf("\n");
+
+    for ( size_t f = 0; f < sizeof(fns) / sizeof(*fns); ++f )
+        for ( size_t s = 0; s < sizeof(strategies) / sizeof(*strategies); ++s )
+        {
+            /* memcmp() doesn't vary by strategy. */
+            if ( f == 2 && s )
+                break;
+
+            libc_init_string(strategies[s].erms, strategies[s].fsrm);
+            memcpy(dst, src, BUF_SIZE);
+
+            printf("%s %-7s", fns[f], f == 2 ? "" : strategies[s].name);
+            for ( size_t j = 0; j < sizeof(sizes) / sizeof(*sizes); ++j )
+                bench(fns[f], sizes[j]);
+            printf("\n");
+        }
+}
+
+int main(int argc, char **argv)
+{
+    bool success = true;
+
+    fill_random(src, sizeof(src));
+
+    for ( size_t i = 0; i < sizeof(strategies) / sizeof(*strategies); ++i )
+        success &= test_strategy(&strategies[i]);
+
+    success &= test_memcmp();
+
+    if ( argc > 1 && !strcmp(argv[1], "--bench") )
+        run_bench();
+
+    printf("%s\n", success ? "Success" : "Failed");
+
+    return !success;
+}
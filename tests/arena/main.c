@@ -0,0 +1,159 @@
+/**
+ * @file tests/arena/main.c
+ * @ref test-arena
+ *
+ * @page test-arena Arena allocator
+ *
+ * Functional test of the framework's arena allocator.
+ *
+ * Checks alignment and separation of allocations, that allocations larger
+ * than a chunk are satisfied, and that arena_reset() returns every page
+ * taken since the mark, with the next allocation reusing the same space.
+ *
+ * With @ref ARENA_GUARD, an access just beyond the end of a chunk's usable
+ * space must suffer @#PF, and the guard page must be mapped again once the
+ * arena is released.  Guard pages aren't supported in unpaged environments.
+ *
+ * @see tests/arena/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Arena allocator";
+
+struct item
+{
+    uint64_t key;
+    unsigned int val;
+};
+
+static void test_alloc(void)
+{
+    struct arena a = ARENA_INIT(PAGE_ORDER_4K, 0);
+    unsigned long nr_free = page_alloc_nr_free();
+    struct arena_mark m;
+    struct item *items;
+    char *p, *q, *big;
+    unsigned int i;
+
+    printk("Test allocation\n");
+
+    p = arena_alloc(&a, 3);
+    q = arena_alloc_aligned(&a, 64, 64);
+    items = arena_new(&a, struct item, 100);
+
+    if ( !p || !q || !items )
+        return xtf_failure("Fail: Allocation failed\n");
+
+    if ( !IS_ALIGNED(_u(p), 16) || !IS_ALIGNED(_u(q), 64) ||
+         !IS_ALIGNED(_u(items), __alignof__(struct item)) )
+        xtf_failure("Fail: Misaligned allocations %p, %p, %p\n", p, q, items);
+
+    if ( q < p + 3 )
+        xtf_failure("Fail: Allocations %p and %p overlap\n", p, q);
+
+    for ( i = 0; i < 100; ++i )
+        items[i] = (struct item){ ~0ull - i, i };
+
+    /* Larger than the default chunk, so needs one of its own. */
+    big = arena_zalloc(&a, 3 * PAGE_SIZE);
+    if ( !big )
+        return xtf_failure("Fail: Large allocation failed\n");
+
+    for ( i = 0; i < 3 * PAGE_SIZE; ++i )
+        if ( big[i] )
+            return xtf_failure("Fail: arena_zalloc() byte %u not zero\n", i);
+
+    memset(big, 0xa5, 3 * PAGE_SIZE);
+
+    for ( i = 0; i < 100; ++i )
+        if ( items[i].key != ~0ull - i || items[i].val != i )
+            return xtf_failure("Fail: Item %u corrupted\n", i);
+
+    /* Scoped reset: everything after the mark goes, and is reused. */
+    m = arena_mark(&a);
+    p = arena_alloc(&a, 100);
+    for ( i = 0; i < 4; ++i )
+        arena_alloc(&a, PAGE_SIZE);
+
+    arena_reset(&a, m);
+
+    q = arena_alloc(&a, 100);
+    if ( q != p )
+        xtf_failure("Fail: Allocation after reset %p, expected %p\n", q, p);
+
+    arena_release(&a);
+
+    if ( page_alloc_nr_free() != nr_free )
+        xtf_failure("Fail: %lu pages free after release, expected %lu\n",
+                    page_alloc_nr_free(), nr_free);
+}
+
+static void test_guard(void)
+{
+    struct arena a = ARENA_INIT(PAGE_ORDER_4K + 1, ARENA_GUARD);
+    exinfo_t fault = 0;
+    char *p, *end;
+
+    printk("Test guard pages\n");
+
+    if ( CONFIG_PAGING_LEVELS == 0 )
+        return printk("  Not supported unpaged\n");
+
+    if ( !(p = arena_alloc(&a, 1)) )
+        return xtf_failure("Fail: Guarded allocation failed\n");
+
+    /* Fill the rest of the chunk.  The guard page follows immediately. */
+    end = a.end;
+    p = arena_alloc_aligned(&a, end - a.ptr, 1);
+    if ( !p || a.ptr != end )
+        return xtf_failure("Fail: Unable to fill chunk\n");
+
+    end[-1] = 0;
+
+    asm volatile ("1: movb $0, %[ptr]; 2:"
+                  _ASM_EXTABLE_HANDLER(1b, 2b, %P[rec])
+                  : "+a" (fault), [ptr] "=m" (*end)
+                  : [rec] "p" (ex_record_fault_eax));
+
+    if ( exinfo_vec(fault) != X86_EXC_PF )
+        xtf_failure("Fail: Write to guard page got %pe, expected #PF\n",
+                    _p(fault));
+
+    arena_release(&a);
+
+    /*
+     * Released chunks must be mapped again.  Probe the page which was the
+     * guard with a read, so the free block isn't disturbed.
+     */
+    fault = 0;
+    asm volatile ("1: movb %[ptr], %%dl; 2:"
+                  _ASM_EXTABLE_HANDLER(1b, 2b, %P[rec])
+                  : "+a" (fault)
+                  : [ptr] "m" (*end), [rec] "p" (ex_record_fault_eax)
+                  : "edx");
+
+    if ( fault )
+        xtf_failure("Fail: Read of released guard page got %pe\n",
+                    _p(fault));
+}
+
+void test_main(void)
+{
+    if ( !page_alloc_nr_free() )
+        return xtf_skip("Skip: No free memory found\n");
+
+    test_alloc();
+    test_guard();
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,204 @@
+/**
+ * @file tests/block-latency/main.c
+ * @ref test-block-latency
+ *
+ * @page test-block-latency vCPU block/wake latency
+ *
+ * Measure how late Xen wakes a blocked vCPU, relative to the deadline it
+ * requested.  The vCPU blocks in three ways:
+ *
+ *  - `SCHEDOP_poll` with a timeout, on an event channel which never fires.
+ *  - `set_timer_op`, then `SCHEDOP_poll` on the `VIRQ_TIMER` event channel.
+ *  - `VCPUOP_set_singleshot_timer`, then `SCHEDOP_poll` on the `VIRQ_TIMER`
+ *    event channel.
+ *
+ * Deadlines are absolute Xen system time, read from the vCPU's
+ * `vcpu_time_info`.  Oversleep is reported in nanoseconds for several sleep
+ * lengths.  Wakeups before the deadline are counted separately.
+ *
+ * If Xen fails to arm a timer, the method is reported as unavailable
+ * (`-ENOSYS`) or as an error, rather than blocking forever.  The test is only
+ * skipped if no method is available.
+ *
+ * Wake latency is dominated by the scheduler.  The `~credit`, `~credit2`,
+ * `~rtds` and `~null` variations place the domain in a cpupool of the same
+ * name.  These cpupools must be created on the host beforehand with
+ * `xl cpupool-create`, using the scheduler of the same name.
+ *
+ * @see tests/block-latency/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "vCPU block/wake latency";
+
+#define NR_SAMPLES 1000
+
+static const unsigned int delays_us[] = { 10, 100, 1000 };
+
+static uint64_t samples[NR_SAMPLES];
+static evtchn_port_t timer_port;
+
+/* Block until timer_port becomes pending. */
+static void wait_timer_port(void)
+{
+    while ( !test_and_clear_bit(timer_port, shared_info.evtchn_pending) )
+        hypercall_poll(timer_port);
+}
+
+/*
+ * Block until @p deadline.  Returns 0, or -errno if the timer couldn't be
+ * armed, in which case nothing would wake the vCPU.
+ */
+static int block_poll(uint64_t deadline)
+{
+    struct sched_poll poll = {
+        .ports = &timer_port,
+        .nr_ports = 1,
+        .timeout = deadline,
+    };
+    int rc;
+
+    while ( xtf_now_ns() < deadline )
+    {
+        rc = hypercall_sched_op(SCHEDOP_poll, &poll);
+        if ( rc )
+            return rc;
+    }
+
+    return 0;
+}
+
+static int block_set_timer_op(uint64_t deadline)
+{
+    int rc = hypercall_set_timer_op(deadline);
+
+    if ( rc )
+        return rc;
+
+    wait_timer_port();
+
+    return 0;
+}
+
+static int block_singleshot(uint64_t deadline)
+{
+    struct vcpu_set_singleshot_timer sst = {
+        .timeout_abs_ns = deadline,
+    };
+    int rc = hypercall_vcpu_op(VCPUOP_set_singleshot_timer, 0, &sst);
+
+    if ( rc )
+        return rc;
+
+    wait_timer_port();
+
+    return 0;
+}
+
+static const struct method
+{
+    const char *name;
+    int (*block)(uint64_t deadline);
+} methods[] = {
+    { "SCHEDOP_poll timeout",   block_poll },
+    { "set_timer_op",           block_set_timer_op },
+    { "VCPUOP singleshot",      block_singleshot },
+};
+
+/* Returns false if the method is unusable. */
+static bool run(const struct method *m, unsigned int delay_us)
+{
+    struct bench_stats s;
+    unsigned int i, nr = 0, early = 0;
+    char label[40];
+    int rc;
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+    {
+        uint64_t deadline = xtf_now_ns() + delay_us * 1000ull, woken;
+
+        rc = m->block(deadline);
+        if ( rc == -ENOSYS )
+        {
+            printk("  %s not available\n", m->name);
+            return false;
+        }
+        else if ( rc )
+        {
+            xtf_error("Error: %s failed: %d\n", m->name, rc);
+            return false;
+        }
+
+        woken = xtf_now_ns();
+
+        /* Early wakeups have no meaningful oversleep.  Count them only. */
+        if ( woken < deadline )
+            early++;
+        else
+            samples[nr++] = woken - deadline;
+    }
+
+    snprintf(label, sizeof(label), "%s, %uus", m->name, delay_us);
+    if ( nr )
+    {
+        bench_summarise(&s, samples, nr, 1);
+        bench_print(label, &s);
+        bench_print_histogram(samples, nr);
+    }
+    else
+        printk("  %-24s no valid samples\n", label);
+
+    if ( early )
+        printk("    %u wakeups before the deadline\n", early);
+
+    return true;
+}
+
+void test_main(void)
+{
+    struct evtchn_bind_virq bind = { .virq = VIRQ_TIMER, .vcpu = 0 };
+    unsigned int i, j;
+    bool ran = false;
+    int rc;
+
+    rc = hypercall_evtchn_bind_virq(&bind);
+    if ( rc )
+        return xtf_error("Error: Unable to bind VIRQ_TIMER: %d\n", rc);
+
+    timer_port = bind.port;
+    if ( timer_port >= (sizeof(shared_info.evtchn_pending) * CHAR_BIT) )
+        return xtf_error("Error: evtchn %u out of evtchn_pending[] range\n",
+                         timer_port);
+
+    /* Only the timers armed by this test may signal VIRQ_TIMER. */
+    hypercall_vcpu_op(VCPUOP_stop_periodic_timer, 0, NULL);
+    test_and_clear_bit(timer_port, shared_info.evtchn_pending);
+
+    printk("Oversleep in ns, %u samples:\n", NR_SAMPLES);
+
+    for ( i = 0; i < ARRAY_SIZE(methods); ++i )
+        for ( j = 0; j < ARRAY_SIZE(delays_us); ++j )
+        {
+            if ( !run(&methods[i], delays_us[j]) )
+                break;
+
+            ran = true;
+        }
+
+    hypercall_evtchn_close(timer_port);
+
+    if ( !ran )
+        return xtf_skip("Skip: No blocking method available\n");
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,151 @@
+/**
+ * @file tests/cacheline-contention/main.c
+ * @ref test-cacheline-contention
+ *
+ * @page test-cacheline-contention Cache line contention
+ *
+ * Measure how throughput scales, from 1 vCPU up to all of them, when vCPUs
+ * contend for cache lines:
+ *
+ *  - shared: every vCPU atomically increments the same counter.
+ *  - false sharing: each vCPU atomically increments its own counter, but the
+ *    counters are packed into a single cache line.
+ *  - padded: each vCPU atomically increments its own counter, on its own
+ *    cache line.  The uncontended baseline.
+ *  - handoff: a token is passed around the vCPUs in turn, each waiting for
+ *    its predecessor, so every pass is a producer/consumer line transfer.
+ *
+ * Results depend heavily on where Xen places the vCPUs, e.g. whether they
+ * share a core as SMT siblings, share a cache, or not.  The `~unpinned`
+ * variation leaves placement to Xen.  The `~pinned` variation pins vCPU n to
+ * pCPU n; how pCPU numbers map onto cores and siblings is host specific, and
+ * shown by `xl info -n`.
+ *
+ * @see tests/cacheline-contention/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Cache line contention";
+
+#define NR_INCS    1000000
+#define NR_PASSES  100000
+
+static atomic_t shared;
+/* Aligned, so up to 16 counters are guaranteed to share one line. */
+static atomic_t packed[NR_CPUS] __aligned(64);
+static struct
+{
+    atomic_t c;
+} __aligned(64) padded[NR_CPUS];
+static unsigned int token;
+
+static struct spin_barrier start;
+static unsigned int nr_running;
+
+static void inc_shared(unsigned int cpu)
+{
+    for ( unsigned int i = 0; i < NR_INCS; ++i )
+        atomic_inc(&shared);
+}
+
+static void inc_packed(unsigned int cpu)
+{
+    for ( unsigned int i = 0; i < NR_INCS; ++i )
+        atomic_inc(&packed[cpu]);
+}
+
+static void inc_padded(unsigned int cpu)
+{
+    for ( unsigned int i = 0; i < NR_INCS; ++i )
+        atomic_inc(&padded[cpu].c);
+}
+
+static void pass_token(unsigned int cpu)
+{
+    unsigned int next = cpu + 1 == nr_running ? 0 : cpu + 1;
+
+    for ( unsigned int i = 0; i < NR_PASSES; ++i )
+    {
+        while ( LOAD_ACQUIRE(&token) != cpu )
+            cpu_relax();
+
+        STORE_RELEASE(&token, next);
+    }
+}
+
+static const struct bench
+{
+    const char *name;
+    void (*fn)(unsigned int cpu);
+    unsigned int ops;           /* Operations per vCPU. */
+} benches[] = {
+    { "shared",        inc_shared, NR_INCS },
+    { "false sharing", inc_packed, NR_INCS },
+    { "padded",        inc_padded, NR_INCS },
+    { "handoff",       pass_token, NR_PASSES },
+};
+
+static const struct bench *cur;
+
+static void worker(unsigned int cpu)
+{
+    spin_barrier_wait(&start, nr_running);
+
+    cur->fn(cpu);
+}
+
+/* Run @p b on @p nr vCPUs at once, and report the aggregate rate. */
+static void run(const struct bench *b, unsigned int nr)
+{
+    unsigned int cpu;
+    uint64_t t, rate;
+    int rc;
+
+    cur = b;
+    nr_running = nr;
+    token = 0;
+    spin_barrier_init(&start);
+
+    rc = smp_start_cpus(nr, worker);
+    if ( rc )
+        return xtf_error("Error: Failed to start APs: %d\n", rc);
+
+    t = xtf_now_ns();
+    worker(0);
+    for ( cpu = 1; cpu < nr; ++cpu )
+        smp_wait_cpu(cpu);
+    t = xtf_now_ns() - t;
+
+    rate = bench_per_sec((uint64_t)nr * b->ops, t);
+    printk("  %-14s %u vCPUs: %12"PRIu64" ops/s total, %12"PRIu64
+           " per vCPU\n", b->name, nr, rate, rate / nr);
+}
+
+void test_main(void)
+{
+    unsigned int nr_cpus = smp_nr_cpus(), nr, i;
+
+    if ( nr_cpus < 2 )
+        return xtf_skip("Skip: No secondary vCPUs\n");
+
+    for ( i = 0; i < ARRAY_SIZE(benches); ++i )
+        for ( nr = 1; nr <= nr_cpus; ++nr )
+            run(&benches[i], nr);
+
+    /* Every increment should have landed. */
+    if ( (unsigned int)atomic_read(&shared) !=
+         NR_INCS * (nr_cpus * (nr_cpus + 1) / 2) )
+        return xtf_failure("Fail: Lost updates to the shared counter\n");
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
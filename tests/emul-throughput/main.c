@@ -0,0 +1,215 @@
+/**
+ * @file tests/emul-throughput/main.c
+ * @ref test-emul-throughput
+ *
+ * @page test-emul-throughput Instruction emulator throughput
+ *
+ * Measure the throughput of Xen's x86 instruction emulator, for a
+ * representative instruction from each of several classes:
+ *
+ *  - ALU operations, register and memory operands.
+ *  - `REP` string operations.
+ *  - Far control transfers (`ljmp` and `lret`).
+ *  - SIMD loads and stores.
+ *  - Segment register loads.
+ *
+ * Each instruction is executed natively, and forced through the emulator
+ * using the Forced Emulation Prefix.  The cost of each is reported in TSC
+ * cycles, along with the emulated instructions per second and the slowdown
+ * relative to native execution.  Native costs include the overhead of an
+ * indirect call per instruction.  Samples during which the vCPU was
+ * descheduled are discarded.
+ *
+ * This test requires a debug Xen, booted with `"hvm_fep"`.
+ *
+ * @see tests/emul-throughput/main.c
+ */
+#include <xtf.h>
+
+#include <arch/div.h>
+
+const char test_title[] = "Instruction emulator throughput";
+
+bool test_needs_fep = true;
+
+#define NR_SAMPLES 64
+#define BATCH      64
+
+static uint64_t samples[NR_SAMPLES];
+static uint32_t tsc_khz;
+
+static unsigned long scratch;
+static char src[64], dst[64];
+static uint8_t vec[16] __aligned(16);
+
+/*
+ * Each instruction is expressed as a macro taking the prefix to use, and
+ * instantiated once natively and once with the Forced Emulation Prefix.
+ */
+#define ALU_REG(pfx)                                                    \
+    asm volatile (pfx "add %%" _ASM_CX ", %%" _ASM_AX ::: "eax", "ecx")
+
+#define ALU_MEM(pfx)                                                    \
+    asm volatile (pfx "add %%" _ASM_AX ", %[m]"                         \
+                  : [m] "+m" (scratch) :: "eax")
+
+#define REP_MOVSB(pfx)                                                  \
+    ({                                                                  \
+        const void *s = src;                                            \
+        void *d = dst;                                                  \
+        unsigned long c = sizeof(dst);                                  \
+                                                                        \
+        asm volatile (pfx "rep movsb"                                   \
+                      : "+S" (s), "+D" (d), "+c" (c) :: "memory");      \
+    })
+
+#define REP_STOSB(pfx)                                                  \
+    ({                                                                  \
+        void *d = dst;                                                  \
+        unsigned long c = sizeof(dst);                                  \
+                                                                        \
+        asm volatile (pfx "rep stosb"                                   \
+                      : "+D" (d), "+c" (c) : "a" (0) : "memory");       \
+    })
+
+#define FAR_JMP(pfx)                                                    \
+    ({                                                                  \
+        struct __packed { uint32_t off; uint16_t sel; }                 \
+            fp = { 0, __KERN_CS };                                      \
+                                                                        \
+        asm volatile ("movl $1f, %[fp];"                                \
+                      pfx "ljmpl *%[fp]; 1:"                            \
+                      : [fp] "+m" (fp) :: "memory");                    \
+    })
+
+#define FAR_RET(pfx)                                                    \
+    asm volatile ("push %[cs];"                                         \
+                  "push $1f;"                                           \
+                  pfx __ASM_SEL(lretl, lretq) "; 1:"                    \
+                  :: [cs] "i" (__KERN_CS) : "memory")
+
+#define SIMD_LOAD(pfx)                                                  \
+    asm volatile (pfx "movups %[v], %%xmm0" :: [v] "m" (vec))
+
+#define SIMD_STORE(pfx)                                                 \
+    asm volatile (pfx "movups %%xmm0, %[v]" : [v] "=m" (vec))
+
+#define SEG_LOAD(pfx)                                                   \
+    asm volatile (pfx "mov %[sel], %%es"                                \
+                  :: [sel] "r" (GDTE_DS32_DPL0 * 8))
+
+#define INSN(name, macro)                                               \
+    static void name ## _native(void) { macro(""); }                    \
+    static void name ## _emul(void) { macro(_ASM_XEN_FEP); }
+
+INSN(alu_reg,    ALU_REG)
+INSN(alu_mem,    ALU_MEM)
+INSN(rep_movsb,  REP_MOVSB)
+INSN(rep_stosb,  REP_STOSB)
+INSN(far_jmp,    FAR_JMP)
+INSN(far_ret,    FAR_RET)
+INSN(simd_load,  SIMD_LOAD)
+INSN(simd_store, SIMD_STORE)
+INSN(seg_load,   SEG_LOAD)
+
+static const struct insn
+{
+    const char *name;
+    void (*native)(void);
+    void (*emul)(void);
+    bool simd;
+} insns[] = {
+#define ENTRY(name, desc, simd) { desc, name ## _native, name ## _emul, simd }
+    ENTRY(alu_reg,    "add reg, reg",         false),
+    ENTRY(alu_mem,    "add reg, mem",         false),
+    ENTRY(rep_movsb,  "rep movsb (64 bytes)", false),
+    ENTRY(rep_stosb,  "rep stosb (64 bytes)", false),
+    ENTRY(far_jmp,    "ljmp *mem",            false),
+    ENTRY(far_ret,    "lret",                 false),
+    ENTRY(simd_load,  "movups mem, xmm",      true),
+    ENTRY(simd_store, "movups xmm, mem",      true),
+    ENTRY(seg_load,   "mov reg, %es",         false),
+#undef ENTRY
+};
+
+static uint64_t sample_insn(void *arg)
+{
+    void (*fn)(void) = *(void (**)(void))arg;
+    uint64_t start = rdtsc_ordered();
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        fn();
+
+    return rdtsc_ordered() - start;
+}
+
+static uint64_t time_insn(void (*fn)(void), struct bench_steal *steal)
+{
+    struct bench_stats s;
+
+    bench_collect(samples, NR_SAMPLES, sample_insn, &fn, steal);
+    bench_summarise(&s, samples, NR_SAMPLES, BATCH);
+
+    return s.median ?: 1;
+}
+
+void test_main(void)
+{
+    unsigned int i;
+
+    tsc_khz = bench_tsc_khz();
+    if ( !tsc_khz )
+        return xtf_error("Error: TSC frequency not reported\n");
+
+    if ( cpu_has_sse )
+    {
+        write_cr0(read_cr0() & ~(X86_CR0_EM | X86_CR0_TS));
+        write_cr4(read_cr4() | X86_CR4_OSFXSR);
+    }
+
+    printk("Median cycles per instruction (%u samples of %u):\n",
+           NR_SAMPLES, BATCH);
+
+    for ( i = 0; i < ARRAY_SIZE(insns); ++i )
+    {
+        const struct insn *insn = &insns[i];
+        struct bench_steal native_steal, emul_steal;
+        uint64_t native, emul, rate, slowdown;
+
+        if ( insn->simd && !cpu_has_sse )
+        {
+            printk("  %-24s not available\n", insn->name);
+            continue;
+        }
+
+        native = time_insn(insn->native, &native_steal);
+        emul = time_insn(insn->emul, &emul_steal);
+
+        rate = tsc_khz * 1000ull;
+        divmod64(&rate, emul);
+
+        slowdown = emul;
+        divmod64(&slowdown, native);
+
+        printk("  %-24s native %6"PRIu64", emulated %8"PRIu64
+               " (%8"PRIu64" insns/s, x%"PRIu64")\n",
+               insn->name, native, emul, rate, slowdown);
+        bench_print_steal(&native_steal);
+        bench_print_steal(&emul_steal);
+    }
+
+    write_es(__KERN_DS);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,173 @@
+/**
+ * @file tests/hvm-pagetable/main.c
+ * @ref test-hvm-pagetable
+ *
+ * @page test-hvm-pagetable HVM pagetable construction
+ *
+ * Functional test of the framework's runtime pagetable API.
+ *
+ * A page from the page allocator is aliased at a linear address outside of
+ * the identity map in 64bit mode (needing new L3, L2 and L1 tables), or in
+ * the high, superpage mapped, part of the identity map in 32bit modes
+ * (needing a superpage to be split).  Writes through the alias must be
+ * visible through the identity map, and the alias must fault once unmapped.
+ *
+ * A 2M block is aliased with hvm_map_range(), which uses a superpage with
+ * PAE paging, and 4K pages with PSE paging.  With 4-level paging and 1G
+ * page support, a 1G alias of the bottom of memory is checked too.
+ *
+ * In 64bit mode, hvm_identmap_ram() extends the identity map to all RAM, and
+ * the last page of RAM, if above 4G, must be accessible.
+ *
+ * @see tests/hvm-pagetable/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "HVM pagetable construction";
+
+#ifdef __x86_64__
+# define ALIAS GB(512)
+#else
+# define ALIAS GB(3)
+#endif
+
+static exinfo_t probe(unsigned long linear)
+{
+    exinfo_t fault = 0;
+    unsigned long tmp;
+
+    asm volatile ("1: mov %[ptr], %[tmp]; 2:"
+                  _ASM_EXTABLE_HANDLER(1b, 2b, %P[rec])
+                  : "+a" (fault), [tmp] "=r" (tmp)
+                  : [ptr] "m" (*(unsigned long *)linear),
+                    [rec] "p" (ex_record_fault_eax));
+
+    return fault;
+}
+
+static void test_4k(void)
+{
+    unsigned long *page = alloc_page(), *alias = _p(ALIAS);
+    exinfo_t fault;
+    int rc;
+
+    printk("Test 4K alias\n");
+
+    if ( !page )
+        return xtf_error("Error: No memory\n");
+
+    rc = hvm_map_pages(ALIAS, _u(page), PAGE_ORDER_4K, PF_SYM(AD, RW));
+    if ( rc )
+        return xtf_failure("Fail: hvm_map_pages() %d\n", rc);
+
+    ACCESS_ONCE(alias[1]) = 0xc2c2c2c2ul;
+    if ( ACCESS_ONCE(page[1]) != 0xc2c2c2c2ul )
+        xtf_failure("Fail: Write via alias not seen, got %#lx\n", page[1]);
+
+    rc = hvm_unmap_pages(ALIAS, PAGE_ORDER_4K);
+    if ( rc )
+        return xtf_failure("Fail: hvm_unmap_pages() %d\n", rc);
+
+    fault = probe(ALIAS);
+    if ( exinfo_vec(fault) != X86_EXC_PF )
+        xtf_failure("Fail: Unmapped alias got %pe, expected #PF\n", _p(fault));
+
+    free_page(page);
+}
+
+static void test_range(void)
+{
+    unsigned long *block = alloc_pages(PAGE_ORDER_2M), *alias = _p(ALIAS);
+    unsigned long last = (MB(2) - PAGE_SIZE) / sizeof(*block);
+    int rc;
+
+    printk("Test 2M range alias\n");
+
+    if ( !block )
+        return printk("  No 2M block available\n");
+
+    rc = hvm_map_range(ALIAS, _u(block), MB(2), PF_SYM(AD, RW));
+    if ( rc )
+        return xtf_failure("Fail: hvm_map_range() %d\n", rc);
+
+    ACCESS_ONCE(alias[0]) = 1;
+    ACCESS_ONCE(alias[last]) = 2;
+    if ( ACCESS_ONCE(block[0]) != 1 || ACCESS_ONCE(block[last]) != 2 )
+        xtf_failure("Fail: Writes via 2M alias not seen\n");
+
+    rc = hvm_unmap_range(ALIAS, MB(2));
+    if ( rc )
+        return xtf_failure("Fail: hvm_unmap_range() %d\n", rc);
+
+    if ( exinfo_vec(probe(ALIAS + MB(1))) != X86_EXC_PF )
+        xtf_failure("Fail: Unmapped 2M alias still accessible\n");
+
+    free_pages(block, PAGE_ORDER_2M);
+}
+
+static void test_1g(void)
+{
+    const char *alias = _p(ALIAS + _u(test_title));
+    int rc;
+
+    printk("Test 1G alias\n");
+
+    if ( CONFIG_PAGING_LEVELS != 4 || !cpu_has_page1gb )
+        return printk("  Not supported\n");
+
+    rc = hvm_map_pages(ALIAS, 0, PAGE_ORDER_1G, PF_SYM(AD));
+    if ( rc )
+        return xtf_failure("Fail: hvm_map_pages() %d\n", rc);
+
+    if ( strcmp(alias, test_title) )
+        xtf_failure("Fail: Title not seen via 1G alias\n");
+
+    rc = hvm_unmap_pages(ALIAS, PAGE_ORDER_1G);
+    if ( rc )
+        xtf_failure("Fail: hvm_unmap_pages() %d\n", rc);
+}
+
+static void test_above_4g(void)
+{
+    uint64_t end = hvm_ram_end();
+    int rc;
+
+    printk("Test identity map above 4G\n");
+
+    if ( CONFIG_PAGING_LEVELS != 4 )
+        return printk("  Not supported\n");
+
+    if ( end <= GB(4) )
+        return printk("  No RAM above 4G\n");
+
+    rc = hvm_identmap_ram();
+    if ( rc )
+        return xtf_failure("Fail: hvm_identmap_ram() %d\n", rc);
+
+    if ( probe(end - PAGE_SIZE) )
+        xtf_failure("Fail: Last page of RAM, %#"PRIx64", not mapped\n",
+                    end - PAGE_SIZE);
+}
+
+void test_main(void)
+{
+    if ( !page_alloc_nr_free() )
+        return xtf_skip("Skip: No free memory found\n");
+
+    test_4k();
+    test_range();
+    test_1g();
+    test_above_4g();
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
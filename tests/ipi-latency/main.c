@@ -0,0 +1,358 @@
+/**
+ * @file tests/ipi-latency/main.c
+ * @ref test-ipi-latency
+ *
+ * @page test-ipi-latency Inter-vCPU IPI latency
+ *
+ * Measure the latency of IPIs from vCPU 0 to vCPU 1, for each mechanism:
+ *
+ *  - Local APIC fixed interrupt, sent by writing the ICR (HVM only).
+ *  - Event channel bound with `EVTCHNOP_bind_ipi`, sent with
+ *    `EVTCHNOP_send`.  The ports are masked, and the receiver waits on the
+ *    pending bit, rather than taking an upcall.
+ *
+ * The receiver is either idle or busy.  Idle means `hlt` for the Local APIC,
+ * and `SCHEDOP_poll` for event channels, so Xen must wake and schedule the
+ * vCPU.  Busy means spinning, with interrupts enabled for the Local APIC.
+ * When idle, the sender waits 50us after the receiver is ready, to let it
+ * block.
+ *
+ * One-way latency is from just before the send, to the receiver noticing the
+ * IPI (entry to the interrupt handler, or the pending bit being seen).  It
+ * relies on the TSC being synchronised across vCPUs.  Round trip latency is
+ * measured on vCPU 0 alone, with the receiver replying using the same
+ * mechanism while vCPU 0 spins.  Both are reported in nanoseconds.
+ *
+ * @see tests/ipi-latency/main.c
+ */
+#include <xtf.h>
+
+#include <arch/apic.h>
+
+const char test_title[] = "Inter-vCPU IPI latency";
+
+#define NR_SAMPLES 1000
+#define IDLE_US    50
+
+static uint64_t samples[NR_SAMPLES];
+static uint64_t send_tsc[NR_SAMPLES], recv_tsc[NR_SAMPLES];
+static uint32_t tsc_khz;
+
+/* Receiver handshake.  Set to the sample number + 1 when ready. */
+static unsigned int ready;
+
+struct mechanism
+{
+    const char *name;
+
+    /* Set up, on the BSP.  Returns non-zero if unavailable. */
+    int (*init)(void);
+
+    /* Set up, on the receiving AP. */
+    void (*ap_init)(void);
+
+    void (*send_to_ap)(void);
+    void (*send_to_bsp)(void);
+
+    /* Wait for an IPI on the AP, returning the TSC when it was noticed. */
+    uint64_t (*ap_wait)(bool idle);
+
+    /* Spin for an IPI on the BSP. */
+    void (*bsp_wait)(void);
+};
+
+#if defined(CONFIG_HVM)
+/* TSC values sampled on entry to the IPI handlers. */
+static uint64_t ap_isr_tsc, bsp_isr_tsc;
+static uint32_t ap_apic_id, bsp_apic_id;
+
+#define ISR_STUB(name, var)                     \
+    void name(void);                            \
+    asm (#name ":;"                             \
+         "push %" _ASM_AX ";"                   \
+         "push %" _ASM_DX ";"                   \
+         "rdtsc;"                               \
+         "mov %eax, " #var ";"                  \
+         "mov %edx, " #var " + 4;"              \
+         "pop %" _ASM_DX ";"                    \
+         "pop %" _ASM_AX ";"                    \
+         __ASM_SEL(iretl, iretq))
+
+ISR_STUB(ap_isr, ap_isr_tsc);
+ISR_STUB(bsp_isr, bsp_isr_tsc);
+
+static int lapic_init(void)
+{
+    const struct xtf_idte ap_idte = {
+        .addr = _u(ap_isr), .cs = __KERN_CS,
+    }, bsp_idte = {
+        .addr = _u(bsp_isr), .cs = __KERN_CS,
+    };
+
+    if ( apic_init(APIC_MODE_X2APIC) && apic_init(APIC_MODE_XAPIC) )
+        return -ENODEV;
+
+    /* HVM APs share the BSP's IDT. */
+    if ( xtf_set_idte(X86_VEC_AVAIL, &ap_idte) ||
+         xtf_set_idte(X86_VEC_AVAIL + 1, &bsp_idte) )
+        return -EIO;
+
+    bsp_apic_id = apic_get_id();
+
+    return 0;
+}
+
+static void lapic_ap_init(void)
+{
+    if ( apic_init_ap() )
+        panic("Failed to initialise AP's local APIC\n");
+
+    ACCESS_ONCE(ap_apic_id) = apic_get_id();
+}
+
+static void lapic_send_to_ap(void)
+{
+    apic_icr_write(apic_icr_dest(ap_apic_id) | APIC_DM_FIXED | X86_VEC_AVAIL);
+}
+
+static void lapic_send_to_bsp(void)
+{
+    apic_icr_write(apic_icr_dest(bsp_apic_id) | APIC_DM_FIXED |
+                   (X86_VEC_AVAIL + 1));
+}
+
+static uint64_t lapic_ap_wait(bool idle)
+{
+    uint64_t tsc;
+
+    if ( idle )
+    {
+        while ( !ACCESS_ONCE(ap_isr_tsc) )
+            asm volatile ("sti; hlt; cli" ::: "memory");
+    }
+    else
+    {
+        asm volatile ("sti" ::: "memory");
+        while ( !ACCESS_ONCE(ap_isr_tsc) )
+            cpu_relax();
+        asm volatile ("cli" ::: "memory");
+    }
+
+    tsc = ap_isr_tsc;
+    ap_isr_tsc = 0;
+    apic_write(APIC_EOI, 0);
+
+    return tsc;
+}
+
+static void lapic_bsp_wait(void)
+{
+    asm volatile ("sti" ::: "memory");
+    while ( !ACCESS_ONCE(bsp_isr_tsc) )
+        cpu_relax();
+    asm volatile ("cli" ::: "memory");
+
+    bsp_isr_tsc = 0;
+    apic_write(APIC_EOI, 0);
+}
+#endif /* CONFIG_HVM */
+
+static evtchn_port_t ap_port, bsp_port;
+
+static int bind_ipi(unsigned int vcpu, evtchn_port_t *port)
+{
+    struct evtchn_bind_ipi bind = { .vcpu = vcpu };
+    int rc = hypercall_evtchn_bind_ipi(&bind);
+
+    if ( rc )
+        return rc;
+
+    if ( bind.port >= (sizeof(shared_info.evtchn_pending) * CHAR_BIT) )
+        return -ERANGE;
+
+    /* Only ever waited on.  Don't take upcalls. */
+    test_and_set_bit(bind.port, shared_info.evtchn_mask);
+    *port = bind.port;
+
+    return 0;
+}
+
+static int evtchn_init(void)
+{
+    return bind_ipi(1, &ap_port) ?: bind_ipi(0, &bsp_port);
+}
+
+static void evtchn_send_to_ap(void)
+{
+    hypercall_evtchn_send(ap_port);
+}
+
+static void evtchn_send_to_bsp(void)
+{
+    hypercall_evtchn_send(bsp_port);
+}
+
+static uint64_t evtchn_ap_wait(bool idle)
+{
+    if ( idle )
+    {
+        while ( !test_and_clear_bit(ap_port, shared_info.evtchn_pending) )
+            hypercall_poll(ap_port);
+    }
+    else
+    {
+        while ( !test_and_clear_bit(ap_port, shared_info.evtchn_pending) )
+            cpu_relax();
+    }
+
+    return rdtsc_ordered();
+}
+
+static void evtchn_bsp_wait(void)
+{
+    while ( !test_and_clear_bit(bsp_port, shared_info.evtchn_pending) )
+        cpu_relax();
+}
+
+static const struct mechanism mechanisms[] = {
+#if defined(CONFIG_HVM)
+    { "LAPIC ICR", lapic_init, lapic_ap_init,
+      lapic_send_to_ap, lapic_send_to_bsp, lapic_ap_wait, lapic_bsp_wait },
+#endif
+    { "Event channel", evtchn_init, NULL,
+      evtchn_send_to_ap, evtchn_send_to_bsp, evtchn_ap_wait, evtchn_bsp_wait },
+};
+
+static const struct mechanism *cur;
+static bool cur_idle, cur_round_trip;
+
+static void receiver(unsigned int cpu)
+{
+    unsigned int i;
+
+    if ( cur->ap_init )
+        cur->ap_init();
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+    {
+        STORE_RELEASE(&ready, i + 1);
+
+        recv_tsc[i] = cur->ap_wait(cur_idle);
+
+        if ( cur_round_trip )
+            cur->send_to_bsp();
+    }
+}
+
+static void run(const struct mechanism *m, bool idle, bool round_trip)
+{
+    struct bench_stats s;
+    unsigned int i, nr = NR_SAMPLES, skewed = 0;
+    uint64_t idle_delay = tsc_khz * IDLE_US / 1000ull;
+    char label[40];
+    int rc;
+
+    cur = m;
+    cur_idle = idle;
+    cur_round_trip = round_trip;
+    ready = 0;
+
+    rc = smp_start_cpu(1, receiver);
+    if ( rc )
+        return xtf_error("Error: Failed to start vCPU 1: %d\n", rc);
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+    {
+        uint64_t t;
+
+        while ( LOAD_ACQUIRE(&ready) != i + 1 )
+            cpu_relax();
+
+        if ( idle )
+        {
+            t = rdtsc_ordered();
+            while ( rdtsc_ordered() - t < idle_delay )
+                cpu_relax();
+        }
+
+        t = rdtsc_ordered();
+        send_tsc[i] = t;
+        m->send_to_ap();
+
+        if ( round_trip )
+        {
+            m->bsp_wait();
+            samples[i] = bench_tsc_to_ns(rdtsc_ordered() - t);
+        }
+    }
+
+    smp_wait_cpu(1);
+
+    if ( !round_trip )
+    {
+        /* Samples skewed by TSC differences between vCPUs are only counted. */
+        for ( i = 0, nr = 0; i < NR_SAMPLES; ++i )
+        {
+            if ( recv_tsc[i] < send_tsc[i] )
+                skewed++;
+            else
+                samples[nr++] = bench_tsc_to_ns(recv_tsc[i] - send_tsc[i]);
+        }
+    }
+
+    snprintf(label, sizeof(label), "%s, %s", idle ? "idle" : "busy",
+             round_trip ? "round trip" : "one-way");
+    if ( nr )
+    {
+        bench_summarise(&s, samples, nr, 1);
+        bench_print(label, &s);
+    }
+    else
+        printk("  %-24s no valid samples\n", label);
+
+    if ( skewed )
+        printk("    %u samples received before being sent\n", skewed);
+}
+
+void test_main(void)
+{
+    unsigned int i;
+
+    if ( smp_nr_cpus() < 2 )
+        return xtf_skip("Skip: No secondary vCPUs\n");
+
+    tsc_khz = bench_tsc_khz();
+    if ( !tsc_khz )
+        return xtf_error("Error: TSC frequency not reported\n");
+
+    printk("IPI latency in ns, %u samples:\n", NR_SAMPLES);
+
+    for ( i = 0; i < ARRAY_SIZE(mechanisms); ++i )
+    {
+        const struct mechanism *m = &mechanisms[i];
+
+        if ( m->init() )
+        {
+            printk("%s: not available\n", m->name);
+            continue;
+        }
+
+        printk("%s:\n", m->name);
+        run(m, true, false);
+        run(m, false, false);
+        run(m, true, true);
+        run(m, false, true);
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
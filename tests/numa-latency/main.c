@@ -0,0 +1,255 @@
+/**
+ * @file tests/numa-latency/main.c
+ * @ref test-numa-latency
+ *
+ * @page test-numa-latency vNUMA local and remote memory access
+ *
+ * Measure memory access latency and read bandwidth from each vNUMA node to
+ * the memory of every node, to confirm that Xen has placed the domain's
+ * memory and vCPUs as the toolstack asked.
+ *
+ * The `~vnuma` variation splits memory and vCPUs over two nodes, on physical
+ * nodes 0 and 1, so needs a host with at least two NUMA nodes; xl fails to
+ * build the domain otherwise.  The `~flat` variation has no vNUMA topology,
+ * and the test skips.
+ *
+ * A 16M buffer is allocated on each node with alloc_pages_node(), and every
+ * page is checked to be on the requested node.  Each node's first vCPU then
+ * chases pointers around a random cycle visiting every 4K page of each
+ * buffer once (reported in TSC cycles per load), and streams 8 byte reads
+ * across it (reported in MiB/s).  A warning is raised if remote memory is no
+ * slower than local memory, which suggests that the vNUMA layout doesn't
+ * reflect the physical placement.
+ *
+ * @see tests/numa-latency/main.c
+ */
+#include <xtf.h>
+
+#include <arch/mm.h>
+
+const char test_title[] = "vNUMA local and remote memory access";
+
+#define NR_SAMPLES 8
+#define NR_STEPS   (1u << 18)
+
+/* Per node buffer, made of 2M blocks from the page allocator. */
+#define NR_BLOCKS  8
+#define BLOCK_SIZE (PAGE_SIZE << PAGE_ORDER_2M)
+#define BUF_SIZE   (NR_BLOCKS * BLOCK_SIZE)
+#define NR_PAGES   (BUF_SIZE >> PAGE_SHIFT)
+
+static char *blocks[NUMA_MAX_NODES][NR_BLOCKS];
+static uint32_t order[NR_PAGES];
+static uint64_t samples[NR_SAMPLES];
+static uint64_t latency[NUMA_MAX_NODES][NUMA_MAX_NODES];
+
+/* Node being measured. */
+static unsigned int mem_node;
+
+/*
+ * Each pointer lives in its own 4K page, at a varying cacheline offset so
+ * they don't all compete for the same cache sets.
+ */
+static void **page_slot(unsigned int node, uint32_t page)
+{
+    return _p(blocks[node][page >> PAGE_ORDER_2M] +
+              ((page & ((1u << PAGE_ORDER_2M) - 1)) << PAGE_SHIFT) +
+              ((page & 63) << 6));
+}
+
+/* Build a single random cycle visiting every page (Sattolo's algorithm). */
+static void build_chain(unsigned int node)
+{
+    uint32_t i, seed = 0x12345678;
+
+    for ( i = 0; i < NR_PAGES; ++i )
+        order[i] = i;
+
+    for ( i = NR_PAGES - 1; i > 0; --i )
+    {
+        uint32_t j, tmp;
+
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        j = seed % i;
+
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for ( i = 0; i < NR_PAGES; ++i )
+        *page_slot(node, order[i]) = page_slot(node, order[(i + 1) % NR_PAGES]);
+}
+
+static uint64_t time_chase(unsigned int node)
+{
+    void *const volatile *p = (void *)page_slot(node, order[0]);
+    uint64_t start = rdtsc_ordered();
+    unsigned int i;
+
+    for ( i = 0; i < NR_STEPS; ++i )
+        p = *p;
+
+    return rdtsc_ordered() - start;
+}
+
+static uint64_t time_read(unsigned int node)
+{
+    uint64_t start = rdtsc_ordered(), sum = 0;
+    unsigned int i, j;
+
+    for ( i = 0; i < NR_BLOCKS; ++i )
+    {
+        const uint64_t *buf = _p(blocks[node][i]);
+
+        for ( j = 0; j < BLOCK_SIZE / sizeof(*buf); ++j )
+            sum += buf[j];
+    }
+
+    asm volatile ("" :: "r" (sum));
+
+    return rdtsc_ordered() - start;
+}
+
+/* Measure mem_node's buffer, from the calling vCPU. */
+static void measure(unsigned int cpu)
+{
+    unsigned int node = numa_cpu_to_node(cpu), i;
+    struct bench_stats s;
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+        samples[i] = time_chase(mem_node);
+    bench_summarise(&s, samples, NR_SAMPLES, NR_STEPS);
+    latency[node][mem_node] = s.median;
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+        samples[i] = time_read(mem_node);
+    bench_summarise(&s, samples, NR_SAMPLES, 1);
+
+    printk("  node %u -> node %u: latency %4"PRIu64" cycles/load, "
+           "read %6"PRIu64" MiB/s\n", node, mem_node, latency[node][mem_node],
+           bench_per_sec(BUF_SIZE >> 20, bench_tsc_to_ns(s.median)));
+}
+
+/* Allocate node's buffer, and check every page is on the node. */
+static bool alloc_buffer(unsigned int node)
+{
+    unsigned long pfn;
+    unsigned int i, j;
+
+    for ( i = 0; i < NR_BLOCKS; ++i )
+    {
+        blocks[node][i] = alloc_pages_node(node, PAGE_ORDER_2M);
+        if ( !blocks[node][i] )
+        {
+            xtf_error("Error: Node %u: only %u of %u 2M blocks available\n",
+                      node, i, NR_BLOCKS);
+            return false;
+        }
+
+        pfn = virt_to_pfn(blocks[node][i]);
+        for ( j = 0; j < (1u << PAGE_ORDER_2M); ++j )
+            if ( numa_pfn_to_node(pfn + j, NULL) != node )
+            {
+                xtf_failure("Fail: pfn %#lx from node %u is on node %u\n",
+                            pfn + j, node, numa_pfn_to_node(pfn + j, NULL));
+                return false;
+            }
+    }
+
+    return true;
+}
+
+void test_main(void)
+{
+    unsigned int nr_nodes = numa_nr_nodes(), cpu_node[NUMA_MAX_NODES];
+    unsigned int i, j, cpu;
+    uint32_t tsc_khz;
+    int rc;
+
+    if ( nr_nodes < 2 )
+        return xtf_skip("Skip: No vNUMA topology\n");
+
+    tsc_khz = bench_tsc_khz();
+    if ( !tsc_khz )
+        return xtf_error("Error: TSC frequency not reported\n");
+
+    for ( i = 0; i < nr_nodes; ++i )
+    {
+        cpu_node[i] = NR_CPUS;
+
+        printk("Node %u: %lu free pages, distances", i,
+               page_alloc_nr_free_node(i));
+        for ( j = 0; j < nr_nodes; ++j )
+            printk(" %u", numa_distance(i, j));
+        printk("\n");
+    }
+
+    for ( cpu = smp_nr_cpus(); cpu-- > 0; )
+    {
+        i = numa_cpu_to_node(cpu);
+        printk("vCPU %u: node %u\n", cpu, i);
+        cpu_node[i] = cpu;
+    }
+
+    for ( i = 0; i < nr_nodes; ++i )
+        if ( !alloc_buffer(i) )
+            return;
+
+    printk("%u MiB per node, TSC %ukHz:\n",
+           (unsigned int)(BUF_SIZE >> 20), tsc_khz);
+
+    for ( i = 0; i < nr_nodes; ++i )
+    {
+        mem_node = i;
+        build_chain(i);
+
+        for ( j = 0; j < nr_nodes; ++j )
+        {
+            cpu = cpu_node[j];
+
+            if ( cpu == NR_CPUS )
+                continue;
+
+            if ( cpu == 0 )
+            {
+                measure(0);
+                continue;
+            }
+
+            rc = smp_start_cpu(cpu, measure);
+            if ( rc )
+                return xtf_error("Error: Failed to start vCPU %u: %d\n",
+                                 cpu, rc);
+            smp_wait_cpu(cpu);
+        }
+    }
+
+    for ( i = 0; i < nr_nodes; ++i )
+    {
+        if ( cpu_node[i] == NR_CPUS )
+        {
+            printk("Node %u has no vCPUs\n", i);
+            continue;
+        }
+
+        for ( j = 0; j < nr_nodes; ++j )
+            if ( j != i && latency[i][j] <= latency[i][i] )
+                xtf_warning("Warning: Node %u memory no slower than local "
+                            "from node %u\n", j, i);
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
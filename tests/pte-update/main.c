@@ -0,0 +1,202 @@
+/**
+ * @file tests/pte-update/main.c
+ * @ref test-pte-update
+ *
+ * @page test-pte-update PV PTE update throughput
+ *
+ * Measure the cost of updating PV pagetable entries, by each mechanism:
+ *
+ *  - `update_va_mapping`, one hypercall per PTE.
+ *  - `mmu_update`, one hypercall per PTE.
+ *  - `mmu_update`, batched with @ref mmu_batch, so the PTEs and the TLB
+ *    flush are submitted together.
+ *  - Direct writes to the PTEs, with `VMASST_TYPE_writable_pagetables`
+ *    enabled, so each write traps to Xen and is emulated.
+ *
+ * Each sample switches 64 PTEs between read-only and read-write, then
+ * flushes the TLB once.  Results are reported in TSC cycles per PTE, and in
+ * PTE updates per second.  Samples during which the vCPU was descheduled are
+ * discarded.
+ *
+ * @see tests/pte-update/main.c
+ */
+#include <xtf.h>
+
+#include <arch/div.h>
+#include <arch/mmu-batch.h>
+#include <arch/pagetable.h>
+
+const char test_title[] = "PV PTE update throughput";
+
+#define NR_SAMPLES  64
+#define BLOCK_ORDER 6
+#define NR_PTES     (1u << BLOCK_ORDER)
+
+static uint64_t samples[NR_SAMPLES];
+static uint32_t tsc_khz;
+
+static char *block;
+static intpte_t *l1e[NR_PTES], pte_rw[NR_PTES], pte_ro[NR_PTES];
+static bool read_only;
+static long err;
+
+static struct mmu_batch batch;
+
+static void record(long rc)
+{
+    if ( rc && !err )
+        err = rc;
+}
+
+static void flush_local(void)
+{
+    mmuext_op_t op = { .cmd = MMUEXT_TLB_FLUSH_LOCAL };
+
+    record(hypercall_mmuext_op(&op, 1, NULL, DOMID_SELF));
+}
+
+static void uvm_update(unsigned int i, intpte_t pte)
+{
+    record(hypercall_update_va_mapping(_u(block) + i * PAGE_SIZE, pte,
+                                       UVMF_NONE));
+}
+
+static void mu_update(unsigned int i, intpte_t pte)
+{
+    mmu_update_t mu = { .ptr = virt_to_maddr(l1e[i]), .val = pte };
+
+    record(hypercall_mmu_update(&mu, 1, NULL, DOMID_SELF));
+}
+
+static void batch_update(unsigned int i, intpte_t pte)
+{
+    mmu_batch_update(&batch, virt_to_maddr(l1e[i]), pte);
+}
+
+static void batch_finish(void)
+{
+    mmu_batch_flush_tlb(&batch);
+    record(mmu_batch_flush(&batch));
+}
+
+static void direct_update(unsigned int i, intpte_t pte)
+{
+    ACCESS_ONCE(*l1e[i]) = pte;
+}
+
+static const struct method
+{
+    const char *name;
+    void (*update)(unsigned int i, intpte_t pte);
+    void (*finish)(void);
+    bool writable;
+} methods[] = {
+    { "update_va_mapping",  uvm_update,    flush_local,  false },
+    { "mmu_update",         mu_update,     flush_local,  false },
+    { "batched mmu_update", batch_update,  batch_finish, false },
+    { "direct write",       direct_update, flush_local,  true  },
+};
+
+static uint64_t sample(void *arg)
+{
+    const struct method *m = arg;
+    const intpte_t *ptes;
+    uint64_t start;
+    unsigned int i;
+
+    read_only = !read_only;
+    ptes = read_only ? pte_ro : pte_rw;
+
+    start = rdtsc_ordered();
+
+    for ( i = 0; i < NR_PTES; ++i )
+        m->update(i, ptes[i]);
+    m->finish();
+
+    return rdtsc_ordered() - start;
+}
+
+static void run(const struct method *m)
+{
+    const intpte_t *ptes;
+    struct bench_stats s;
+    struct bench_steal steal;
+    unsigned int i;
+    uint64_t rate;
+
+    if ( m->writable && pv_writable_pagetables() )
+        return printk("%s: VMASST_TYPE_writable_pagetables not available\n",
+                      m->name);
+
+    err = 0;
+    bench_collect(samples, NR_SAMPLES, sample, (void *)m, &steal);
+
+    if ( err )
+        return xtf_failure("Fail: %s: error %ld\n", m->name, err);
+
+    ptes = read_only ? pte_ro : pte_rw;
+    for ( i = 0; i < NR_PTES; ++i )
+        if ( *l1e[i] != ptes[i] )
+            return xtf_failure("Fail: %s: PTE %u is %"PRIpte
+                               ", expected %"PRIpte"\n",
+                               m->name, i, *l1e[i], ptes[i]);
+
+    bench_summarise(&s, samples, NR_SAMPLES, NR_PTES);
+
+    rate = tsc_khz * 1000ull;
+    divmod64(&rate, s.median ?: 1);
+
+    printk("%s:\n", m->name);
+    bench_print("cycles per PTE", &s);
+    printk("  %-24s %8"PRIu64" PTEs/s\n", "throughput", rate);
+    bench_print_steal(&steal);
+}
+
+void test_main(void)
+{
+    unsigned int i;
+
+    tsc_khz = bench_tsc_khz();
+    if ( !tsc_khz )
+        return xtf_error("Error: TSC frequency not reported\n");
+
+    if ( !(block = alloc_pages(BLOCK_ORDER)) )
+        return xtf_error("Error: Unable to allocate %u pages\n", NR_PTES);
+
+    for ( i = 0; i < NR_PTES; ++i )
+    {
+        void *va = block + i * PAGE_SIZE;
+
+        if ( !(l1e[i] = pv_l1e(_u(va))) )
+            return xtf_error("Error: No L1 entry for %p\n", va);
+
+        pte_rw[i] = pte_from_virt(va, PF_SYM(AD, RW, P));
+        pte_ro[i] = pte_from_virt(va, PF_SYM(AD, P));
+    }
+
+    mmu_batch_init(&batch);
+
+    printk("PTE updates, %u samples of %u:\n", NR_SAMPLES, NR_PTES);
+
+    for ( i = 0; i < ARRAY_SIZE(methods); ++i )
+        run(&methods[i]);
+
+    for ( i = 0; i < NR_PTES; ++i )
+        uvm_update(i, pte_rw[i]);
+    flush_local();
+
+    if ( !err )
+        free_pages(block, BLOCK_ORDER);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
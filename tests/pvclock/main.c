@@ -0,0 +1,88 @@
+/**
+ * @file tests/pvclock/main.c
+ * @ref test-pvclock
+ *
+ * @page test-pvclock pvclock read cost
+ *
+ * Report the pvclock parameters Xen provides in vCPU 0's `vcpu_time_info`,
+ * and the cost of reading the time with xtf_now_ns(), compared to a bare
+ * `rdtsc`.  Also checks that successive readings never go backwards.
+ *
+ * @see tests/pvclock/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "pvclock read cost";
+
+#define NR_SAMPLES 64
+#define BATCH      256
+
+static uint64_t samples[NR_SAMPLES];
+
+static uint64_t time_rdtsc(void)
+{
+    uint64_t start = rdtsc_ordered();
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        rdtsc_ordered();
+
+    return rdtsc_ordered() - start;
+}
+
+static uint64_t time_now(void)
+{
+    uint64_t start = rdtsc_ordered();
+    unsigned int i;
+
+    for ( i = 0; i < BATCH; ++i )
+        xtf_now_ns();
+
+    return rdtsc_ordered() - start;
+}
+
+void test_main(void)
+{
+    const struct vcpu_time_info *t = &shared_info.vcpu_info[0].time;
+    struct bench_stats s;
+    uint64_t prev, ns;
+    unsigned int i;
+
+    printk("pvclock: mul %#x, shift %d, flags %#x, TSC %sstable\n",
+           t->tsc_to_system_mul, t->tsc_shift, t->flags,
+           xtf_tsc_stable() ? "" : "not ");
+
+    prev = xtf_now_ns();
+    for ( i = 0; i < NR_SAMPLES * BATCH; ++i )
+    {
+        ns = xtf_now_ns();
+        if ( ns < prev )
+            return xtf_failure("Fail: time went backwards, %"PRIu64
+                               " => %"PRIu64"\n", prev, ns);
+        prev = ns;
+    }
+
+    printk("Cycles per read (%u samples of %u):\n", NR_SAMPLES, BATCH);
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+        samples[i] = time_rdtsc();
+    bench_summarise(&s, samples, NR_SAMPLES, BATCH);
+    bench_print("rdtsc_ordered()", &s);
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+        samples[i] = time_now();
+    bench_summarise(&s, samples, NR_SAMPLES, BATCH);
+    bench_print("xtf_now_ns()", &s);
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -278,6 +278,55 @@ static void test_vsnprintf_crlf(void)
     test_vsnprintf_crlf_one("%s", "\n");
 }
 
+static void test_atomics(void)
+{
+    atomic_t a = ATOMIC_INIT(5);
+    atomic64_t a64 = ATOMIC64_INIT(0xffffffffLL);
+
+    printk("Test: Atomic operations\n");
+
+    if ( atomic_fetch_add(&a, 3) != 5 || atomic_read(&a) != 8 )
+        xtf_failure("Fail: atomic_fetch_add(), got %d\n", atomic_read(&a));
+
+    if ( atomic_xchg(&a, 1) != 8 || atomic_read(&a) != 1 )
+        xtf_failure("Fail: atomic_xchg(), got %d\n", atomic_read(&a));
+
+    if ( atomic_cmpxchg(&a, 0, 2) != 1 || atomic_read(&a) != 1 )
+        xtf_failure("Fail: atomic_cmpxchg() mismatch, got %d\n",
+                    atomic_read(&a));
+
+    if ( atomic_cmpxchg(&a, 1, 2) != 1 || atomic_read(&a) != 2 )
+        xtf_failure("Fail: atomic_cmpxchg() match, got %d\n",
+                    atomic_read(&a));
+
+    /* Carry out of the low half. */
+    if ( atomic64_fetch_add(&a64, 1) != 0xffffffffLL ||
+         atomic64_read(&a64) != 0x100000000LL )
+        xtf_failure("Fail: atomic64_fetch_add(), got %#"PRIx64"\n",
+                    atomic64_read(&a64));
+
+    if ( atomic64_xchg(&a64, -1) != 0x100000000LL ||
+         atomic64_read(&a64) != -1 )
+        xtf_failure("Fail: atomic64_xchg(), got %#"PRIx64"\n",
+                    atomic64_read(&a64));
+
+    if ( atomic64_cmpxchg(&a64, -1, 0x123456789LL) != -1 ||
+         atomic64_read(&a64) != 0x123456789LL )
+        xtf_failure("Fail: atomic64_cmpxchg(), got %#"PRIx64"\n",
+                    atomic64_read(&a64));
+
+#ifdef __x86_64__
+    if ( cpu_has_cx16 )
+    {
+        static unsigned __int128 val __aligned(16);
+        unsigned __int128 new = ((unsigned __int128)1 << 64) | 2;
+
+        if ( cmpxchg16b(&val, 0, new) != 0 || val != new )
+            xtf_failure("Fail: cmpxchg16b() didn't exchange\n");
+    }
+#endif
+}
+
 void test_main(void)
 {
     /*
@@ -306,6 +355,7 @@ void test_main(void)
     test_custom_idte();
     test_driver_init();
     test_vsnprintf_crlf();
+    test_atomics();
 
     if ( has_xenstore )
         test_xenstore();
@@ -0,0 +1,141 @@
+/**
+ * @file tests/smp/main.c
+ * @ref test-smp
+ *
+ * @page test-smp SMP bring-up
+ *
+ * Functional test of the framework's secondary vCPU support.  Every AP is
+ * started, checks its smp_processor_id() and takes an exception, then is
+ * restarted a second time with a different callback.
+ *
+ * Finally, all vCPUs increment shared atomic counters in lockstep, using a
+ * sense-reversing barrier, to check that no updates are lost.
+ *
+ * @see tests/smp/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "SMP bring-up";
+
+static unsigned int seen_id[NR_CPUS];
+static bool seen_fault[NR_CPUS];
+static unsigned int restarted[NR_CPUS];
+
+static void ap_first(unsigned int cpu)
+{
+    exinfo_t fault = 0;
+
+    ACCESS_ONCE(seen_id[cpu]) = smp_processor_id();
+
+    /* Check the AP's exception handling works. */
+    asm volatile ("1: ud2a; 2:"
+                  _ASM_EXTABLE_HANDLER(1b, 2b, %P[rec])
+                  : "+a" (fault)
+                  : [rec] "p" (ex_record_fault_eax));
+
+    ACCESS_ONCE(seen_fault[cpu]) = fault == EXINFO_SYM(UD, 0);
+}
+
+static void ap_second(unsigned int cpu)
+{
+    ACCESS_ONCE(restarted[cpu])++;
+}
+
+#define NR_ROUNDS 1000
+
+static atomic_t counter;
+static atomic64_t counter64;
+static struct sense_barrier round_barrier;
+static bool round_mismatch;
+
+/* Every vCPU increments the counters once per round, in lockstep. */
+static void ap_rounds(unsigned int cpu)
+{
+    unsigned int i, nr = round_barrier.nr;
+
+    for ( i = 0; i < NR_ROUNDS; ++i )
+    {
+        atomic_fetch_add(&counter, 1);
+        atomic64_fetch_add(&counter64, 1ULL << 32);
+
+        sense_barrier_wait(&round_barrier);
+
+        if ( (unsigned int)atomic_read(&counter) != (i + 1) * nr )
+            ACCESS_ONCE(round_mismatch) = true;
+
+        sense_barrier_wait(&round_barrier);
+    }
+}
+
+void test_main(void)
+{
+    unsigned int cpu, nr = smp_nr_cpus();
+    int rc;
+
+    printk("%u vCPUs\n", nr);
+
+    if ( nr < 2 )
+        return xtf_skip("Skip: No secondary vCPUs\n");
+
+    if ( smp_processor_id() != 0 )
+        xtf_failure("Fail: BSP has ID %u\n", smp_processor_id());
+
+    rc = smp_start_cpus(nr, ap_first);
+    if ( rc )
+        return xtf_error("Error: unable to start APs: %d\n", rc);
+
+    for ( cpu = 1; cpu < nr; ++cpu )
+    {
+        smp_wait_cpu(cpu);
+
+        if ( seen_id[cpu] != cpu )
+            xtf_failure("Fail: CPU%u saw ID %u\n", cpu, seen_id[cpu]);
+
+        if ( !seen_fault[cpu] )
+            xtf_failure("Fail: CPU%u didn't handle #UD\n", cpu);
+    }
+
+    rc = smp_start_cpus(nr, ap_second);
+    if ( rc )
+        return xtf_error("Error: unable to restart APs: %d\n", rc);
+
+    for ( cpu = 1; cpu < nr; ++cpu )
+    {
+        smp_wait_cpu(cpu);
+
+        if ( restarted[cpu] != 1 )
+            xtf_failure("Fail: CPU%u ran second callback %u times\n",
+                        cpu, restarted[cpu]);
+    }
+
+    round_barrier = (struct sense_barrier)SENSE_BARRIER_INIT(nr);
+
+    rc = smp_start_cpus(nr, ap_rounds);
+    if ( rc )
+        return xtf_error("Error: unable to restart APs: %d\n", rc);
+
+    ap_rounds(0);
+
+    for ( cpu = 1; cpu < nr; ++cpu )
+        smp_wait_cpu(cpu);
+
+    if ( round_mismatch )
+        xtf_failure("Fail: sense_barrier_wait() didn't hold vCPUs\n");
+
+    if ( (unsigned int)atomic_read(&counter) != NR_ROUNDS * nr ||
+         atomic64_read(&counter64) != ((int64_t)NR_ROUNDS * nr) << 32 )
+        xtf_failure("Fail: Lost atomic updates: %d, %#"PRIx64"\n",
+                    atomic_read(&counter), atomic64_read(&counter64));
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,176 @@
+/**
+ * @file tests/spinlock-contention/main.c
+ * @ref test-spinlock-contention
+ *
+ * @page test-spinlock-contention Spinlock contention
+ *
+ * Measure lock handoff latency and throughput of the framework's ticket and
+ * MCS spinlocks, for 2 up to all vCPUs hammering a single lock with a short
+ * critical section.
+ *
+ * Each lock is measured with plain spinning, where a waiter for a preempted
+ * lock holder relies on pause-loop exiting (HVM on capable hardware only) to
+ * give up its pCPU, and with the paravirtual slow path, where waiters block
+ * in `SCHEDOP_poll` and are kicked with `EVTCHNOP_send` on unlock.
+ *
+ * Handoff latency is the time, in TSC cycles, from one vCPU releasing the
+ * lock to a different vCPU acquiring it.  It relies on the TSC being
+ * synchronised across vCPUs.  Throughput is total acquisitions per second.
+ *
+ * The `~dedicated` variation expects each vCPU to have a pCPU of its own.
+ * The `~overcommit` variation restricts the domain to pCPUs 0-1, so lock
+ * holders are regularly preempted.
+ *
+ * @see tests/spinlock-contention/main.c
+ */
+#include <xtf.h>
+
+const char test_title[] = "Spinlock contention";
+
+#define NR_ITERS 500
+
+static struct ticket_lock tlock = TICKET_LOCK_INIT;
+static struct mcs_lock mlock = MCS_LOCK_INIT;
+
+/* Protected by the lock under test. */
+static struct
+{
+    unsigned int owner;
+    uint64_t released;
+} crit;
+
+static uint64_t handoff[NR_CPUS][NR_ITERS];
+static unsigned int nr_handoff[NR_CPUS];
+static uint64_t samples[NR_CPUS * NR_ITERS];
+
+static struct spin_barrier start;
+static unsigned int nr_running;
+
+static void ticket_lock(void)   { ticket_spin_lock(&tlock); }
+static void ticket_unlock(void) { ticket_spin_unlock(&tlock); }
+static void mcs_lock(void)      { mcs_spin_lock(&mlock); }
+static void mcs_unlock(void)    { mcs_spin_unlock(&mlock); }
+
+static const struct lock_ops
+{
+    const char *name;
+    void (*lock)(void);
+    void (*unlock)(void);
+} locks[] = {
+    { "ticket", ticket_lock, ticket_unlock },
+    { "mcs",    mcs_lock,    mcs_unlock },
+};
+
+static const struct lock_ops *ops;
+
+static void worker(unsigned int cpu)
+{
+    unsigned int i, n = 0;
+
+    spin_barrier_wait(&start, nr_running);
+
+    for ( i = 0; i < NR_ITERS; ++i )
+    {
+        ops->lock();
+
+        /* Owner ~0 is the initial state, not a release. */
+        if ( crit.owner != cpu && crit.owner != ~0u )
+            handoff[cpu][n++] = rdtsc_ordered() - crit.released;
+
+        crit.owner = cpu;
+        crit.released = rdtsc_ordered();
+
+        ops->unlock();
+    }
+
+    nr_handoff[cpu] = n;
+}
+
+static void run(const struct lock_ops *l, unsigned int nr, bool pv)
+{
+    struct bench_stats s;
+    unsigned int cpu, total = 0;
+    uint64_t t;
+    char label[40];
+    int rc;
+
+    ops = l;
+    spinlock_pv = pv;
+    nr_running = nr;
+    spin_barrier_init(&start);
+    crit.owner = ~0u;
+    crit.released = rdtsc_ordered();
+
+    rc = smp_start_cpus(nr, worker);
+    if ( rc )
+        return xtf_error("Error: Failed to start APs: %d\n", rc);
+
+    t = xtf_now_ns();
+    worker(0);
+    for ( cpu = 1; cpu < nr; ++cpu )
+        smp_wait_cpu(cpu);
+    t = xtf_now_ns() - t;
+
+    for ( cpu = 0; cpu < nr; ++cpu )
+    {
+        memcpy(&samples[total], handoff[cpu],
+               nr_handoff[cpu] * sizeof(*samples));
+        total += nr_handoff[cpu];
+    }
+
+    snprintf(label, sizeof(label), "%s %s, %u vCPUs",
+             l->name, pv ? "pv  " : "spin", nr);
+
+    if ( total )
+    {
+        bench_summarise(&s, samples, total, 1);
+        bench_print(label, &s);
+    }
+    else
+        printk("  %s: no handoffs\n", label);
+
+    printk("    %"PRIu64" acquisitions/s, %u%% handed off\n",
+           bench_per_sec(nr * NR_ITERS, t), total * 100 / (nr * NR_ITERS));
+}
+
+void test_main(void)
+{
+    unsigned int nr_cpus = smp_nr_cpus(), nr, i;
+    bool have_pv;
+    int rc;
+
+    if ( nr_cpus < 2 )
+        return xtf_skip("Skip: No secondary vCPUs\n");
+
+    rc = spinlock_pv_init(nr_cpus);
+    have_pv = !rc;
+    if ( !have_pv )
+        printk("Paravirt slow path unavailable: %d\n", rc);
+
+    if ( !xtf_tsc_stable() )
+        printk("Warning: TSC not stable.  Handoff latencies may be skewed\n");
+
+    printk("Handoff latency in TSC cycles, %u acquisitions per vCPU:\n",
+           NR_ITERS);
+
+    for ( nr = 2; nr <= nr_cpus; ++nr )
+        for ( i = 0; i < ARRAY_SIZE(locks); ++i )
+        {
+            run(&locks[i], nr, false);
+
+            if ( have_pv )
+                run(&locks[i], nr, true);
+        }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,311 @@
+/**
+ * @file tests/timer-latency/main.c
+ * @ref test-timer-latency
+ *
+ * @page test-timer-latency Timer interrupt latency
+ *
+ * Measure the delay between the programmed expiry of a timer and entry into
+ * its interrupt handler, for each of the timer sources Xen emulates for HVM
+ * guests:
+ *
+ *  - Local APIC timer, in one-shot mode.
+ *  - Local APIC timer, in TSC-deadline mode (if available).
+ *  - HPET comparator, routed through the IO-APIC.
+ *
+ * Each timer is armed a short distance into the future, repeatedly, and the
+ * TSC is sampled on entry to the interrupt handler.  For TSC-deadline, the
+ * expiry is known exactly.  For the other sources, the expiry is calculated
+ * from the TSC immediately after the arming access, using the Local APIC timer
+ * frequency (calibrated against the TSC) or the HPET period respectively.
+ * The cost of returning from an emulated arming access is therefore not
+ * included in the latency.
+ *
+ * Samples are taken with the vCPU both halted, which involves Xen's scheduler
+ * to wake the vCPU, and spinning with interrupts enabled.  Results are
+ * reported in nanoseconds, along with a histogram to show the jitter.
+ * Interrupts which arrive before the programmed expiry are counted
+ * separately.
+ *
+ * @see tests/timer-latency/main.c
+ */
+#include <xtf.h>
+
+#include <arch/div.h>
+
+const char test_title[] = "Timer interrupt latency";
+
+#define NR_SAMPLES 4096
+#define DELAY_US   100
+
+static uint64_t samples[NR_SAMPLES];
+static uint32_t tsc_khz;
+
+/* TSC value sampled on entry to timer_isr(). */
+static uint64_t isr_tsc;
+
+void timer_isr(void);
+asm ("timer_isr:;"
+     "push %" _ASM_AX ";"
+     "push %" _ASM_DX ";"
+     "rdtsc;"
+     "mov %eax, isr_tsc;"
+     "mov %edx, isr_tsc + 4;"
+     "pop %" _ASM_DX ";"
+     "pop %" _ASM_AX ";"
+     __ASM_SEL(iretl, iretq));
+
+static const struct xtf_idte idte = {
+    .addr = _u(timer_isr),
+    .cs = __KERN_CS,
+};
+
+struct timer_source
+{
+    const char *name;
+
+    /* Set up the timer.  Returns non-zero if it is unavailable. */
+    int (*init)(void);
+
+    /* Arm the timer, and return the TSC value at which it should fire. */
+    uint64_t (*arm)(void);
+
+    void (*fini)(void);
+};
+
+/* Local APIC timer, one-shot mode. */
+static uint32_t lapic_ticks;
+static uint64_t lapic_delay;
+
+static int lapic_init(void)
+{
+    uint64_t start, elapsed, delay = (uint64_t)tsc_khz * DELAY_US;
+    uint32_t ticks;
+
+    /*
+     * Calibrate the Local APIC timer against the TSC, by counting down for
+     * 10ms.
+     */
+    apic_write(APIC_TDCR, APIC_TDR_DIV_1);
+    apic_write(APIC_LVTT, APIC_LVT_MASKED);
+    apic_write(APIC_TMICT, ~0u);
+
+    start = rdtsc_ordered();
+    while ( rdtsc_ordered() - start < tsc_khz * 10ull )
+        cpu_relax();
+
+    ticks = ~0u - apic_read(APIC_TMCCT);
+    elapsed = rdtsc_ordered() - start;
+
+    apic_write(APIC_TMICT, 0);
+
+    if ( !ticks )
+        return -ENODEV;
+
+    /* Convert DELAY_US into timer ticks, and back to exact TSC cycles. */
+    divmod64(&delay, 1000);
+    delay *= ticks;
+    divmod64(&delay, elapsed);
+    lapic_ticks = delay ?: 1;
+
+    lapic_delay = (uint64_t)lapic_ticks * elapsed;
+    divmod64(&lapic_delay, ticks);
+
+    apic_write(APIC_LVTT, APIC_TIMER_ONESHOT | X86_VEC_AVAIL);
+
+    return 0;
+}
+
+static uint64_t lapic_arm(void)
+{
+    apic_write(APIC_TMICT, lapic_ticks);
+
+    return rdtsc_ordered() + lapic_delay;
+}
+
+static void lapic_fini(void)
+{
+    apic_write(APIC_TMICT, 0);
+    apic_write(APIC_LVTT, APIC_LVT_MASKED);
+}
+
+/* Local APIC timer, TSC-deadline mode. */
+static uint64_t deadline_delay;
+
+static int deadline_init(void)
+{
+    if ( !cpu_has_tsc_deadline )
+        return -ENODEV;
+
+    deadline_delay = (uint64_t)tsc_khz * DELAY_US;
+    divmod64(&deadline_delay, 1000);
+
+    apic_write(APIC_LVTT, APIC_TIMER_TSC_DEADLINE | X86_VEC_AVAIL);
+
+    return 0;
+}
+
+static uint64_t deadline_arm(void)
+{
+    uint64_t deadline = rdtsc() + deadline_delay;
+
+    wrmsr(MSR_TSC_DEADLINE, deadline);
+
+    return deadline;
+}
+
+static void deadline_fini(void)
+{
+    wrmsr(MSR_TSC_DEADLINE, 0);
+    apic_write(APIC_LVTT, APIC_LVT_MASKED);
+}
+
+/* HPET timer 0, routed through the IO-APIC. */
+static unsigned int hpet_irq;
+static uint64_t hpet_ticks, hpet_delay;
+
+static int hpet_timer_init(void)
+{
+    uint32_t route;
+
+    if ( hpet_init() || !hpet_nr_timers || ioapic_init() )
+        return -ENODEV;
+
+    /* Use the lowest IRQ which timer 0 can be routed to. */
+    route = hpet_read32(HPET_Tn_ROUTE_CAP(0));
+    if ( !route )
+        return -ENODEV;
+
+    for ( hpet_irq = 0; !(route & (1u << hpet_irq)); ++hpet_irq )
+        ;
+
+    if ( ioapic_set_redir(hpet_irq, X86_VEC_AVAIL, false) ||
+         ioapic_set_mask(hpet_irq, false) )
+        return -ENODEV;
+
+    /* Convert DELAY_US into HPET ticks, and back to exact TSC cycles. */
+    hpet_ticks = DELAY_US * 1000000000ull;
+    divmod64(&hpet_ticks, hpet_period);
+    hpet_ticks = hpet_ticks ?: 1;
+
+    hpet_delay = hpet_ticks * hpet_period;
+    divmod64(&hpet_delay, 1000000);
+    hpet_delay *= tsc_khz;
+    divmod64(&hpet_delay, 1000000);
+
+    return 0;
+}
+
+static uint64_t hpet_timer_arm(void)
+{
+    hpet_init_timer(0, hpet_irq, hpet_ticks, false, false, false);
+
+    return rdtsc_ordered() + hpet_delay;
+}
+
+static void hpet_timer_fini(void)
+{
+    hpet_write32(HPET_Tn_CFG(0), 0);
+    ioapic_set_mask(hpet_irq, true);
+}
+
+static const struct timer_source sources[] = {
+    { "LAPIC one-shot",    lapic_init,      lapic_arm,      lapic_fini },
+    { "LAPIC TSC-deadline", deadline_init,  deadline_arm,   deadline_fini },
+    { "HPET via IO-APIC",  hpet_timer_init, hpet_timer_arm, hpet_timer_fini },
+};
+
+static void run(const struct timer_source *src, bool halt)
+{
+    const char *name = halt ? "halted" : "spinning";
+    struct bench_stats s;
+    unsigned int i, nr = 0, early = 0;
+
+    for ( i = 0; i < NR_SAMPLES; ++i )
+    {
+        uint64_t expiry;
+
+        ACCESS_ONCE(isr_tsc) = 0;
+        expiry = src->arm();
+
+        if ( halt )
+        {
+            while ( !ACCESS_ONCE(isr_tsc) )
+                asm volatile ("sti; hlt; cli" ::: "memory");
+        }
+        else
+        {
+            asm volatile ("sti" ::: "memory");
+            while ( !ACCESS_ONCE(isr_tsc) )
+                cpu_relax();
+            asm volatile ("cli" ::: "memory");
+        }
+
+        apic_write(APIC_EOI, 0);
+
+        /* Early interrupts have no meaningful latency.  Count them only. */
+        if ( isr_tsc < expiry )
+            early++;
+        else
+            samples[nr++] = bench_tsc_to_ns(isr_tsc - expiry);
+    }
+
+    if ( nr )
+    {
+        bench_summarise(&s, samples, nr, 1);
+        bench_print(name, &s);
+        bench_print_histogram(samples, nr);
+    }
+    else
+        printk("  %-24s no valid samples\n", name);
+
+    if ( early )
+        printk("    %u interrupts arrived early\n", early);
+}
+
+void test_main(void)
+{
+    unsigned int i;
+    int rc;
+
+    if ( apic_init(APIC_MODE_X2APIC) && apic_init(APIC_MODE_XAPIC) )
+        return xtf_skip("Skip: No usable Local APIC\n");
+
+    rc = xtf_set_idte(X86_VEC_AVAIL, &idte);
+    if ( rc )
+        return xtf_error("Error: xtf_set_idte() failed: %d\n", rc);
+
+    tsc_khz = bench_tsc_khz();
+    if ( !tsc_khz )
+        return xtf_error("Error: TSC frequency not reported\n");
+
+    printk("Interrupt latency in ns, %u samples, %uus timeout, TSC %ukHz:\n",
+           NR_SAMPLES, DELAY_US, tsc_khz);
+
+    for ( i = 0; i < ARRAY_SIZE(sources); ++i )
+    {
+        const struct timer_source *src = &sources[i];
+
+        if ( src->init() )
+        {
+            printk("%s: not available\n", src->name);
+            continue;
+        }
+
+        printk("%s:\n", src->name);
+        run(src, true);
+        run(src, false);
+        src->fini();
+    }
+
+    xtf_success(NULL);
+}
+
+/*
+ * Local variables:
+ * mode: C
+ * c-file-style: "BSD"
+ * c-basic-offset: 4
+ * tab-width: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -30,14 +30,14 @@ static uint8_t tsc_page[PAGE_SIZE] __page_aligned_bss;
  *
  * APs atomic inc read*, and wait on start*.
  */
-static volatile struct {
-    unsigned int ready1;
-    unsigned int ready2;
-    bool start1;
-    bool start2;
+static struct {
+    atomic_t ready1;
+    atomic_t ready2;
+    volatile bool start1;
+    volatile bool start2;
 } wait;
 
-static void ap_thread(void)
+static void ap_thread(unsigned int cpu)
 {
     for ( ;; )
     {
@@ -47,71 +47,18 @@ static void ap_thread(void)
          * de-scheduled by Xen.
          */
 
-        asm volatile ("lock addl $1, %0" : "+m" (wait.ready1));
+        atomic_inc(&wait.ready1);
         while ( wait.start1 == 0 )
             rmb();
 
         wrmsr(HV_X64_MSR_REFERENCE_TSC, 0);
 
-        asm volatile ("lock addl $1, %0" : "+m" (wait.ready2));
+        atomic_inc(&wait.ready2);
         while ( wait.start2 == 0 )
             rmb();
     }
 }
 
-static bool launch_aps(void)
-{
-    static uint8_t stack[PAGE_SIZE * NR_APS] __page_aligned_bss;
-
-    struct xen_vcpu_hvm_context ap = {
-        /* 32bit Flat Mode */
-        .mode = VCPU_HVM_MODE_32B,
-        .cpu_regs.x86_32 = {
-            .eip = _u(&ap_thread),
-
-            /* Same as BSP */
-            .cr0 = read_cr0(),
-            .cr4 = read_cr4(),
-
-            .cs_limit = ~0U,
-            .ds_limit = ~0U,
-            .ss_limit = ~0U,
-            .es_limit = ~0U,
-            .tr_limit = 0x67,
-
-            .cs_ar = 0xc9b,
-            .ds_ar = 0xc93,
-            .ss_ar = 0xc93,
-            .es_ar = 0xc93,
-            .tr_ar = 0x08b,
-        },
-    };
-
-    for ( unsigned int cpu = 1; cpu <= NR_APS; ++cpu )
-    {
-        int rc;
-
-        ap.cpu_regs.x86_32.esp = _u(stack) + cpu * PAGE_SIZE;
-
-        rc = hypercall_vcpu_op(VCPUOP_initialise, cpu, &ap);
-
-        if ( rc )
-        {
-            xtf_error("Error: unable to init CPU%u: %d\n", cpu, rc);
-            return false;
-        }
-
-        rc = hypercall_vcpu_op(VCPUOP_up, cpu, NULL);
-        if ( rc )
-        {
-            xtf_error("Error: unable to start CPU%u: %d\n", cpu, rc);
-            return false;
-        }
-    }
-
-    return true;
-}
-
 void test_main(void)
 {
     unsigned long tsc_gfn = virt_to_gfn(tsc_page);
@@ -122,27 +69,27 @@ void test_main(void)
         .domid = DOMID_SELF,
     };
 
-    if ( !launch_aps() )
-        return;
+    long rc = smp_start_cpus(NR_APS + 1, ap_thread);
+
+    if ( rc )
+        return xtf_error("Error: unable to start APs: %ld\n", rc);
 
     for ( unsigned int i = 0; i < MAX_ITER; i++ )
     {
-        long rc;
-
-        while ( wait.ready1 < NR_APS )
+        while ( atomic_read(&wait.ready1) < NR_APS )
             rmb();
 
-        wait.ready2 = 0;
+        atomic_set(&wait.ready2, 0);
         wait.start2 = false;
 
         wrmsr(HV_X64_MSR_REFERENCE_TSC, _u(tsc_page) | 1);
 
         wait.start1 = true;
 
-        while ( wait.ready2 < NR_APS )
+        while ( atomic_read(&wait.ready2) < NR_APS )
             rmb();
 
-        wait.ready1 = 0;
+        atomic_set(&wait.ready1, 0);
         wait.start1 = false;
 
         wait.start2 = true;